@@ -23,6 +23,10 @@
 #include <set>
 #include <vector>
 
+namespace llvm {
+class BasicBlock;
+}
+
 namespace klee {
 class Array;
 class CallPathNode;
@@ -57,6 +61,10 @@ struct StackFrame {
   // of intrinsic lowering.
   MemoryObject *varargs;
 
+  /// The number of iterations of the loops of the function (by header)
+  /// since they were last entered.
+  std::map<llvm::BasicBlock*, unsigned> loopIterations;
+
   StackFrame(KInstIterator caller, KFunction *kf);
   StackFrame(const StackFrame &s);
   ~StackFrame();
@@ -126,9 +134,25 @@ public:
   /// @brief Whether a new instruction was covered in this state
   bool coveredNew;
 
+  /// @brief Coverage epoch (see getCoverageEpoch) at which the coverage
+  /// information used to weight this state last changed
+  uint64_t coverageEpoch;
+
   /// @brief Disables forking for this state. Set by user code
   bool forkDisabled;
 
+  /// @brief Whether every fork on the path of this state was recorded in
+  /// its path stream, so it can be reconstructed by replaying that path
+  /// (switches and internal forks are not recorded)
+  bool replayable;
+
+  /// @brief The choice made at each fork of this state on a symbolic
+  /// condition, internal ones included: at a two-way fork, the side taken
+  /// (0 or 1), plus 2 if it was the only feasible one; at a switch with
+  /// several feasible targets, the index of the target. Only recorded when
+  /// checkpointing.
+  std::vector<unsigned> forkChoices;
+
   /// @brief Set containing which lines in which files are covered by this state
   std::map<const std::string *, std::set<unsigned> > coveredLines;
 
@@ -143,12 +167,19 @@ public:
   /// @brief Set of used array names for this state.  Used to avoid collisions.
   std::set<std::string> arrayNames;
 
+  /// @brief Dense identifier of this state among all live states. Ids of
+  /// destroyed states are reused, so they can index per-state vectors.
+  unsigned id;
+
   std::string getFnAlias(std::string fn);
   void addFnAlias(std::string old_fn, std::string new_fn);
   void removeFnAlias(std::string fn);
 
 private:
-  ExecutionState() : ptreeNode(0) {}
+  ExecutionState() : ptreeNode(0), id(allocateId()) {}
+
+  static unsigned allocateId();
+  static void releaseId(unsigned id);
 
 public:
   ExecutionState(KFunction *kf);
@@ -54,6 +54,8 @@ namespace klee {
     std::set<const std::string *, ltstr> internedStrings;
 
   private:
+    InstructionInfoTable();
+
     const std::string *internString(std::string s);
     bool getInstructionDebugInfo(const llvm::Instruction *I,
                                  const std::string *&File, unsigned &Line);
@@ -62,6 +64,15 @@ namespace klee {
     InstructionInfoTable(llvm::Module *m);
     ~InstructionInfoTable();
 
+    /// Read a table saved by write() for the same module, which avoids
+    /// printing the module to find the assembly lines. Return null if the
+    /// file cannot be read or does not match the module.
+    static InstructionInfoTable *read(llvm::Module *m,
+                                      const std::string &path);
+
+    /// Save the table to the given file, returning false on failure.
+    bool write(llvm::Module *m, const std::string &path) const;
+
     unsigned getMaxID() const;
     const InstructionInfo &getInfo(const llvm::Instruction*) const;
     const InstructionInfo &getFunctionInfo(const llvm::Function*) const;
@@ -17,6 +17,8 @@
 #include <set>
 #include <vector>
 
+#include <stdint.h>
+
 namespace llvm {
   class BasicBlock;
   class Constant;
@@ -54,6 +56,20 @@ namespace klee {
     /// "coverable" for statistics and search heuristics.
     bool trackCoverage;
 
+    /// The header of the innermost loop containing each block which is in
+    /// a loop (as found by LoopInfo).
+    std::map<llvm::BasicBlock*, llvm::BasicBlock*> loopHeaders;
+
+    /// The header of the loop directly containing each nested loop, by
+    /// header.
+    std::map<llvm::BasicBlock*, llvm::BasicBlock*> outerLoopHeaders;
+
+    /// The back edges of the loops, as (latch, header) pairs.
+    std::set< std::pair<llvm::BasicBlock*, llvm::BasicBlock*> > backEdges;
+
+    /// The number of forks within each loop, by loop header.
+    std::map<llvm::BasicBlock*, uint64_t> loopForks;
+
   private:
     KFunction(const KFunction&);
     KFunction &operator=(const KFunction&);
@@ -117,6 +133,18 @@ namespace klee {
     // Mark function with functionName as part of the KLEE runtime
     void addInternalFunction(const char* functionName);
 
+    /// Run the transformations preparing the module for interpretation.
+    void transform(const Interpreter::ModuleOptions &opts,
+                   const std::string &intrinsicLib);
+
+    /// Replace the module and instruction table by those of the given
+    /// cache entry, returning false if it is missing or incomplete.
+    bool loadFromCache(const std::string &entry);
+
+    /// Save the prepared module, instruction table and assembly to the
+    /// given cache entry.
+    void saveToCache(const std::string &entry, const std::string &assembly);
+
   public:
     KModule(llvm::Module *_module);
     ~KModule();
@@ -127,6 +155,10 @@ namespace klee {
     void prepare(const Interpreter::ModuleOptions &opts, 
                  InterpreterHandler *ihandler);
 
+    /// Return a hash of the prepared module, which identifies it (and so its
+    /// instruction ids) across KLEE processes.
+    uint64_t computeHash() const;
+
     /// Return an id for the given constant, creating a new one if necessary.
     unsigned getConstantID(llvm::Constant *c, KInstruction* ki);
   };
@@ -13,6 +13,7 @@
 #include <string>
 
 namespace llvm {
+  class BasicBlock;
   class Function;
   class Instruction;
   class Module; 
@@ -36,6 +37,17 @@ namespace klee {
   /// terminates in a direct call).
   bool functionEscapes(const llvm::Function *f);
 
+  /// Mark the instructions of the basic blocks of module which do not occur
+  /// in the same function of base (for instance the previous version of the
+  /// program) with "klee.changed" metadata. Basic blocks are compared by
+  /// their instructions and operands, ignoring value names and debug
+  /// information, so unrelated changes elsewhere in a function do not mark
+  /// them. Return the number of marked basic blocks.
+  unsigned markChangedCode(const llvm::Module *base, llvm::Module *module);
+
+  /// Return true iff the instruction was marked by markChangedCode.
+  bool isChangedCode(const llvm::Instruction *i);
+
 }
 
 #endif
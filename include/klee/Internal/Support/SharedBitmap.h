@@ -0,0 +1,51 @@
+//===-- SharedBitmap.h ------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_SHAREDBITMAP_H
+#define KLEE_SHAREDBITMAP_H
+
+#include <stdint.h>
+#include <string>
+
+namespace klee {
+  /// SharedBitmap - A bitmap in a file mapped in memory, shared by several
+  /// KLEE processes. Bits are only ever set, atomically, so each bit is
+  /// set first by exactly one of the processes.
+  class SharedBitmap {
+    volatile uint32_t *words;
+    unsigned numBits;
+    size_t mappedSize;
+
+  public:
+    SharedBitmap();
+    ~SharedBitmap();
+
+    /// Map the bitmap in the given file, creating it if needed. The tag
+    /// identifies what the bits stand for. Return false on failure, or if
+    /// the file holds a bitmap of another size or tag.
+    bool open(const std::string &path, unsigned numBits, uint64_t tag);
+
+    /// Return true if the given bit is set.
+    bool test(unsigned bit) const {
+      return (words[bit / 32] >> (bit % 32)) & 1;
+    }
+
+    /// Set the given bit, returning true if it was not set before.
+    bool set(unsigned bit) {
+      uint32_t mask = 1u << (bit % 32);
+      if (words[bit / 32] & mask)
+        return false;
+      return !(__sync_fetch_and_or(&words[bit / 32], mask) & mask);
+    }
+
+    unsigned size() const { return numBits; }
+  };
+}
+
+#endif
@@ -0,0 +1,75 @@
+//===-- WorkQueue.h ---------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_WORKQUEUE_H
+#define KLEE_WORKQUEUE_H
+
+#include <string>
+#include <vector>
+
+namespace klee {
+  /// WorkQueue - A queue of path prefixes shared by several KLEE processes
+  /// through a directory, used for distributed exploration.
+  ///
+  /// Each job is a path prefix in the .path file format, stored in the
+  /// "pending" subdirectory. A worker claims a job by renaming it, so each
+  /// job is taken by exactly one worker. The "jobs" file counts the jobs
+  /// which are pending or being explored, and is only updated under a
+  /// lock: it is incremented before a job is published, and decremented
+  /// once the job is done, after the jobs it published. The exploration is
+  /// finished once the count drops to zero, as no worker can publish more.
+  ///
+  /// The job of a worker which dies is never done, so the count would stay
+  /// above zero: whoever notices (the coordinator, on the exit status of
+  /// the worker) aborts the queue instead, which also finishes it.
+  class WorkQueue {
+    std::string pendingDir, countFile, claimedFile, abortFile;
+    unsigned workerID;
+    unsigned jobsPushed;
+
+    /// Add delta to the number of unfinished jobs, and return the new
+    /// number in result (if not null). Return false on failure.
+    bool updateCount(int delta, unsigned *result) const;
+
+  public:
+    WorkQueue(const std::string &directory, unsigned workerID);
+    ~WorkQueue();
+
+    /// Create the queue directory, returning false on failure.
+    static bool create(const std::string &directory);
+
+    /// Publish a job exploring the subtree below the given path.
+    bool push(const std::vector<bool> &path);
+
+    /// Claim the oldest pending job, returning false if there is none.
+    /// Each claimed job must be followed by a call to done().
+    bool pop(std::vector<bool> &path);
+
+    /// Mark the current job as finished, once its jobs are published.
+    void done();
+
+    /// Return the number of pending jobs.
+    unsigned getNumPending() const;
+
+    /// Mark the exploration as failed, so that it is finished for every
+    /// worker even though some jobs are not done.
+    void abort();
+
+    /// Return true if the queue was aborted.
+    bool isAborted() const;
+
+    /// Return true if every job is done, so no worker may publish more, or
+    /// if the queue was aborted.
+    bool isFinished() const;
+
+    unsigned getWorkerID() const { return workerID; }
+  };
+}
+
+#endif
@@ -0,0 +1,30 @@
+//===-- Affinity.h ----------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_UTIL_AFFINITY_H
+#define KLEE_UTIL_AFFINITY_H
+
+namespace klee {
+  namespace util {
+
+    /// Pin this process to a single core, chosen by slot among the cores
+    /// it may run on. Consecutive slots go to different NUMA nodes, so
+    /// independent processes get their own caches and memory bandwidth.
+    /// Return false if pinning is not supported.
+    bool pinToCore(unsigned slot);
+
+    /// Let this process run on any core of the NUMA node it currently runs
+    /// on. Memory is allocated on the node of the core touching it first,
+    /// so the process keeps its memory local. Return false if pinning is
+    /// not supported.
+    bool pinToCurrentNode();
+  }
+}
+
+#endif
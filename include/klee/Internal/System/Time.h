@@ -18,6 +18,10 @@ namespace klee {
     /// Seconds spent by this process in user mode.
     double getUserTime();
 
+    /// Seconds spent in user mode by the child processes of this process
+    /// which have been waited for (forked solvers and test case processes).
+    double getChildrenUserTime();
+
     /// Wall time in seconds.
     double getWallTime();
 
@@ -27,6 +27,7 @@ namespace klee {
 class ExecutionState;
 class Interpreter;
 class TreeStreamWriter;
+class WorkQueue;
 
 class InterpreterHandler {
 public:
@@ -103,6 +104,10 @@ public:
   setModule(llvm::Module *module, 
             const ModuleOptions &opts) = 0;
 
+  // change the handler receiving the output of the interpreter, e.g. to
+  // write it to another directory. only allowed before the first run.
+  virtual void setInterpreterHandler(InterpreterHandler *ih) = 0;
+
   // supply a tree stream writer which the interpreter will use
   // to record the concrete path (as a stream of '0' and '1' bytes).
   virtual void setPathWriter(TreeStreamWriter *tsw) = 0;
@@ -120,6 +125,18 @@ public:
   // a user specified path. use null to reset.
   virtual void setReplayPath(const std::vector<bool> *path) = 0;
 
+  // supply a queue shared with other processes exploring the same
+  // program. the replay path is then only a prefix to explore below, and
+  // part of the states are handed over to the queue when it runs low.
+  // requires a path writer. use null to reset.
+  virtual void setWorkQueue(WorkQueue *queue) = 0;
+
+  // resume the exploration saved in the checkpoint of the given output
+  // directory, setting the number of paths left to explore. return false
+  // if there is no checkpoint.
+  virtual bool loadCheckpoint(const std::string &directory,
+                              unsigned &numPaths) = 0;
+
   // supply a set of symbolic bindings that will be used as "seeds"
   // for the search. use null to reset.
   virtual void useSeeds(const std::vector<struct KTest *> *seeds) = 0;
@@ -187,6 +187,50 @@ namespace klee {
                           const std::vector<const Array*> &objects,
                           std::vector< std::vector<unsigned char> > &result);
 
+    /// getValues - Compute one possible value for each of the given
+    /// expressions. All values are taken from a single satisfying assignment,
+    /// so this requires at most one query to the underlying solver no matter
+    /// how many expressions are given.
+    ///
+    /// \param [out] results - On success, a value for each expression (in the
+    /// same order) in some satisfying assignment.
+    ///
+    /// \return True on success.
+    bool getValues(const ConstraintManager &constraints,
+                   const std::vector< ref<Expr> > &exprs,
+                   std::vector< ref<ConstantExpr> > &results);
+
+    /// getUniqueValue - Compute one possible value for the given expression,
+    /// and whether it is the only possible value.
+    ///
+    /// \param [out] result - On success, a value for the expression in some
+    /// satisfying assignment.
+    /// \param [out] isUnique - On success, true iff the expression must be
+    /// equal to result.
+    ///
+    /// \return True on success.
+    bool getUniqueValue(const Query&, ref<ConstantExpr> &result,
+                        bool &isUnique);
+
+    /// getRange - Compute a tight range of possible values for a given
+    /// expression, together with one possible value.
+    ///
+    /// The search for the bounds starts from the sample value, so a unique
+    /// expression only costs the queries made by getUniqueValue.
+    ///
+    /// \param [out] min, max - On success, the bounds of the expression.
+    /// \param [out] sample - On success, a value for the expression in some
+    /// satisfying assignment.
+    ///
+    /// \return True on success.
+    ///
+    /// \post(mustBeTrue(min <= e <= max) && 
+    ///       mayBeTrue(min == e) &&
+    ///       mayBeTrue(max == e) &&
+    ///       mayBeTrue(sample == e))
+    bool getRange(const Query&, ref<ConstantExpr> &min,
+                  ref<ConstantExpr> &max, ref<ConstantExpr> &sample);
+
     /// getRange - Compute a tight range of possible values for a given
     /// expression.
     ///
@@ -274,6 +318,14 @@ namespace klee {
   /// \param s - The underlying solver to use.
   Solver *createCachingSolver(Solver *s);
 
+  /// createCanonicalizingSolver - Create a solver which rewrites queries
+  /// into a canonical form (constraints sorted, symbolic arrays renamed in
+  /// order of first use) before forwarding them, so that caches below it
+  /// hit on queries which only differ in the names of their arrays.
+  ///
+  /// \param s - The underlying solver to use.
+  Solver *createCanonicalizingSolver(Solver *s);
+
   /// createCexCachingSolver - Create a counterexample caching solver. This is a
   /// more sophisticated cache which records counterexamples for a constraint
   /// set and uses subset/superset relations among constraints to try and
@@ -296,6 +348,24 @@ namespace klee {
   /// \param s - The underlying solver to use.
   Solver *createIndependentSolver(Solver *s);
   
+  /// createCoalescingSolver - Create a solver which remembers the outcome of
+  /// the most recent queries (including failures) and answers identical
+  /// queries, as issued by sibling states in close succession, without
+  /// forwarding them. It is meant to sit below the independent solver, so
+  /// that the branch condition separating the siblings is left out.
+  ///
+  /// \param s - The underlying solver to use.
+  Solver *createCoalescingSolver(Solver *s);
+
+  /// createIntervalSolver - Create a solver which tries to answer queries
+  /// using an abstract domain of intervals and known bits for every symbolic
+  /// byte, falling back to the underlying solver when the domain is too
+  /// imprecise. Domains are computed incrementally for constraint sets which
+  /// extend a previously seen one.
+  ///
+  /// \param s - The underlying solver to use.
+  Solver *createIntervalSolver(Solver *s);
+
   /// createPCLoggingSolver - Create a solver which will forward all queries
   /// after writing them to the given path in .pc format.
   Solver *createPCLoggingSolver(Solver *s, std::string path,
@@ -23,9 +23,12 @@ namespace stats {
   extern Statistic queryCacheMisses;
   extern Statistic queryCexCacheHits;
   extern Statistic queryCexCacheMisses;
+  extern Statistic queryCoalesced;
   extern Statistic queryConstructTime;
   extern Statistic queryConstructs;
   extern Statistic queryCounterexamples;
+  extern Statistic queryIntervalHits;
+  extern Statistic queryIntervalMisses;
   extern Statistic queryTime;
   
 #ifdef DEBUG
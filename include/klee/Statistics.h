@@ -37,14 +37,30 @@ namespace klee {
     StatisticRecord &operator +=(const StatisticRecord &sr);
   };
 
-  class StatisticManager {
-  private:
-    bool enabled;
-    std::vector<Statistic*> stats;
+  /// StatisticShard - The statistics updated by one thread, which are
+  /// incremented without synchronization and summed when read. The current
+  /// index and context are also those of the thread.
+  struct StatisticShard {
     uint64_t *globalStats;
+    /// The indexed values, by statistic and then by index, so the values
+    /// of the few statistics read across all instructions are contiguous.
     uint64_t *indexedStats;
     StatisticRecord *contextStats;
     unsigned index;
+    StatisticShard *next;
+  };
+
+  class StatisticManager {
+  private:
+    bool enabled;
+    std::vector<Statistic*> stats;
+    unsigned totalIndices;
+    /// The shards of all the threads which used statistics, newest first.
+    StatisticShard *shards;
+    static __thread StatisticShard *currentShard;
+
+    StatisticShard *addShard();
+    StatisticShard &getShard();
 
   public:
     StatisticManager();
@@ -55,8 +71,8 @@ namespace klee {
     StatisticRecord *getContext();
     void setContext(StatisticRecord *sr); /* null to reset */
 
-    void setIndex(unsigned i) { index = i; }
-    unsigned getIndex() { return index; }
+    void setIndex(unsigned i) { getShard().index = i; }
+    unsigned getIndex() { return getShard().index; }
     unsigned getNumStatistics() { return stats.size(); }
     Statistic &getStatistic(unsigned i) { return *stats[i]; }
     
@@ -64,7 +80,7 @@ namespace klee {
     void incrementStatistic(Statistic &s, uint64_t addend);
     uint64_t getValue(const Statistic &s) const;
     void incrementIndexedValue(const Statistic &s, unsigned index, 
-                               uint64_t addend) const;
+                               uint64_t addend);
     uint64_t getIndexedValue(const Statistic &s, unsigned index) const;
     void setIndexedValue(const Statistic &s, unsigned index, uint64_t value);
     int getStatisticID(const std::string &name) const;
@@ -73,23 +89,30 @@ namespace klee {
 
   extern StatisticManager *theStatisticManager;
 
+  inline StatisticShard &StatisticManager::getShard() {
+    if (!currentShard)
+      currentShard = addShard();
+    return *currentShard;
+  }
+
   inline void StatisticManager::incrementStatistic(Statistic &s, 
                                                    uint64_t addend) {
     if (enabled) {
-      globalStats[s.id] += addend;
-      if (indexedStats) {
-        indexedStats[index*stats.size() + s.id] += addend;
-        if (contextStats)
-          contextStats->data[s.id] += addend;
+      StatisticShard &shard = getShard();
+      shard.globalStats[s.id] += addend;
+      if (shard.indexedStats) {
+        shard.indexedStats[s.id*totalIndices + shard.index] += addend;
+        if (shard.contextStats)
+          shard.contextStats->data[s.id] += addend;
       }
     }
   }
 
   inline StatisticRecord *StatisticManager::getContext() {
-    return contextStats;
+    return getShard().contextStats;
   }
   inline void StatisticManager::setContext(StatisticRecord *sr) {
-    contextStats = sr;
+    getShard().contextStats = sr;
   }
 
   inline void StatisticRecord::zero() {
@@ -130,24 +153,32 @@ namespace klee {
   }
 
   inline uint64_t StatisticManager::getValue(const Statistic &s) const {
-    return globalStats[s.id];
+    uint64_t value = 0;
+    for (StatisticShard *shard = shards; shard; shard = shard->next)
+      value += shard->globalStats[s.id];
+    return value;
   }
 
   inline void StatisticManager::incrementIndexedValue(const Statistic &s, 
                                                       unsigned index,
-                                                      uint64_t addend) const {
-    indexedStats[index*stats.size() + s.id] += addend;
+                                                      uint64_t addend) {
+    getShard().indexedStats[s.id*totalIndices + index] += addend;
   }
 
   inline uint64_t StatisticManager::getIndexedValue(const Statistic &s, 
                                                     unsigned index) const {
-    return indexedStats[index*stats.size() + s.id];
+    uint64_t value = 0;
+    for (StatisticShard *shard = shards; shard; shard = shard->next)
+      value += shard->indexedStats[s.id*totalIndices + index];
+    return value;
   }
 
   inline void StatisticManager::setIndexedValue(const Statistic &s, 
                                                 unsigned index,
                                                 uint64_t value) {
-    indexedStats[index*stats.size() + s.id] = value;
+    for (StatisticShard *shard = shards; shard; shard = shard->next)
+      shard->indexedStats[s.id*totalIndices + index] = 0;
+    getShard().indexedStats[s.id*totalIndices + index] = value;
   }
 }
 
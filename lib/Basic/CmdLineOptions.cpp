@@ -31,11 +31,29 @@ UseCache("use-cache",
          llvm::cl::init(true),
          llvm::cl::desc("Use validity caching (default=on)"));
 
+llvm::cl::opt<bool>
+UseQueryCanonicalization("use-query-canonicalization",
+                         llvm::cl::init(false),
+                         llvm::cl::desc("Rename arrays and sort constraints before "
+                                        "looking queries up in the caches (default=off)"));
+
 llvm::cl::opt<bool>
 UseIndependentSolver("use-independent-solver",
                      llvm::cl::init(true),
                      llvm::cl::desc("Use constraint independence (default=on)"));
 
+llvm::cl::opt<bool>
+UseQueryCoalescing("use-query-coalescing",
+                   llvm::cl::init(false),
+                   llvm::cl::desc("Answer repeated identical queries from a window of "
+                                  "recent results, including failures (default=off)"));
+
+llvm::cl::opt<bool>
+UseIntervalSolver("use-interval-solver",
+                  llvm::cl::init(false),
+                  llvm::cl::desc("Try to answer queries using intervals and known bits "
+                                 "before invoking the rest of the solver chain (default=off)"));
+
 llvm::cl::opt<bool>
 DebugValidateSolver("debug-validate-solver",
 		             llvm::cl::init(false));
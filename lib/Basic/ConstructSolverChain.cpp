@@ -51,9 +51,20 @@ namespace klee
 	  if (UseCache)
 		solver = createCachingSolver(solver);
 
+	  if (UseQueryCanonicalization)
+		solver = createCanonicalizingSolver(solver);
+
+	  // Below the independence solver, the queries of sibling states only
+	  // differ when the constraints they forked on are relevant.
+	  if (UseQueryCoalescing)
+		solver = createCoalescingSolver(solver);
+
 	  if (UseIndependentSolver)
 		solver = createIndependentSolver(solver);
 
+	  if (UseIntervalSolver)
+		solver = createIntervalSolver(solver);
+
 	  if (DebugValidateSolver)
 		solver = createValidatingSolver(solver, coreSolver);
 
@@ -13,31 +13,65 @@
 
 using namespace klee;
 
+__thread StatisticShard *StatisticManager::currentShard = 0;
+
 StatisticManager::StatisticManager()
   : enabled(true),
-    globalStats(0),
-    indexedStats(0),
-    contextStats(0),
-    index(0) {
+    totalIndices(0),
+    shards(0) {
 }
 
 StatisticManager::~StatisticManager() {
-  if (globalStats) delete[] globalStats;
-  if (indexedStats) delete[] indexedStats;
+  while (shards) {
+    StatisticShard *shard = shards;
+    shards = shard->next;
+    delete[] shard->globalStats;
+    delete[] shard->indexedStats;
+    delete shard;
+  }
+}
+
+static uint64_t *newCounters(unsigned size) {
+  uint64_t *counters = new uint64_t[size];
+  memset(counters, 0, sizeof(*counters) * size);
+  return counters;
+}
+
+StatisticShard *StatisticManager::addShard() {
+  StatisticShard *shard = new StatisticShard();
+  shard->globalStats = newCounters(stats.size());
+  shard->indexedStats =
+    totalIndices ? newCounters(totalIndices * stats.size()) : 0;
+  shard->contextStats = 0;
+  shard->index = 0;
+
+  // Publish the shard without a lock; readers only ever walk the list.
+  do {
+    shard->next = shards;
+  } while (!__sync_bool_compare_and_swap(&shards, shard->next, shard));
+  return shard;
 }
 
-void StatisticManager::useIndexedStats(unsigned totalIndices) {  
-  if (indexedStats) delete[] indexedStats;
-  indexedStats = new uint64_t[totalIndices * stats.size()];
-  memset(indexedStats, 0, sizeof(*indexedStats) * totalIndices * stats.size());
+void StatisticManager::useIndexedStats(unsigned _totalIndices) {
+  totalIndices = _totalIndices;
+  for (StatisticShard *shard = shards; shard; shard = shard->next) {
+    delete[] shard->indexedStats;
+    shard->indexedStats = newCounters(totalIndices * stats.size());
+  }
 }
 
 void StatisticManager::registerStatistic(Statistic &s) {
-  if (globalStats) delete[] globalStats;
+  // Statistics are registered during static initialization, before any
+  // other thread exists.
   s.id = stats.size();
   stats.push_back(&s);
-  globalStats = new uint64_t[stats.size()];
-  memset(globalStats, 0, sizeof(*globalStats)*stats.size());
+  for (StatisticShard *shard = shards; shard; shard = shard->next) {
+    uint64_t *globalStats = newCounters(stats.size());
+    memcpy(globalStats, shard->globalStats,
+           sizeof(*globalStats) * (stats.size() - 1));
+    delete[] shard->globalStats;
+    shard->globalStats = globalStats;
+  }
 }
 
 int StatisticManager::getStatisticID(const std::string &name) const {
@@ -19,13 +19,25 @@ using namespace klee;
 
 ///
 
+unsigned AddressSpace::hashBinding(const MemoryObject *mo,
+                                   const ObjectState *os) {
+  unsigned res = mo->id * Expr::MAGIC_HASH_CONSTANT + os->getContentHash();
+  return res * Expr::MAGIC_HASH_CONSTANT;
+}
+
 void AddressSpace::bindObject(const MemoryObject *mo, ObjectState *os) {
   assert(os->copyOnWriteOwner==0 && "object already has owner");
+  if (changedObjects.insert(mo).second)
+    if (const ObjectState *old = findObject(mo))
+      contentHash -= hashBinding(mo, old);
   os->copyOnWriteOwner = cowKey;
   objects = objects.replace(std::make_pair(mo, os));
 }
 
 void AddressSpace::unbindObject(const MemoryObject *mo) {
+  if (!changedObjects.erase(mo))
+    if (const ObjectState *os = findObject(mo))
+      contentHash -= hashBinding(mo, os);
   objects = objects.remove(mo);
 }
 
@@ -39,6 +51,12 @@ ObjectState *AddressSpace::getWriteable(const MemoryObject *mo,
                                         const ObjectState *os) {
   assert(!os->readOnly);
 
+  // The object is about to be written: take its hash out of the sum until
+  // the next call to getContentHash(). Its current hash is cached, as it
+  // was computed when added to the sum.
+  if (changedObjects.insert(mo).second)
+    contentHash -= hashBinding(mo, os);
+
   if (cowKey==os->copyOnWriteOwner) {
     return const_cast<ObjectState*>(os);
   } else {
@@ -318,7 +336,7 @@ bool AddressSpace::copyInConcretes() {
           return false;
         } else {
           ObjectState *wos = getWriteable(mo, os);
-          memcpy(wos->concreteStore, address, mo->size);
+          wos->writeConcreteStore(address);
         }
       }
     }
@@ -329,6 +347,17 @@ bool AddressSpace::copyInConcretes() {
 
 /***/
 
+unsigned AddressSpace::getContentHash() const {
+  for (std::set<const MemoryObject*>::iterator it = changedObjects.begin(),
+         ie = changedObjects.end(); it != ie; ++it)
+    if (const ObjectState *os = findObject(*it))
+      contentHash += hashBinding(*it, os);
+  changedObjects.clear();
+  return contentHash;
+}
+
+/***/
+
 bool MemoryObjectLT::operator()(const MemoryObject *a, const MemoryObject *b) const {
   return a->address < b->address;
 }
@@ -15,6 +15,8 @@
 #include "klee/Expr.h"
 #include "klee/Internal/ADT/ImmutableMap.h"
 
+#include <set>
+
 namespace klee {
   class ExecutionState;
   class MemoryObject;
@@ -38,6 +40,15 @@ namespace klee {
     /// Epoch counter used to control ownership of objects.
     mutable unsigned cowKey;
 
+    /// The sum of the hashes of the bindings, except those of the objects
+    /// bound or made writeable since it was last brought up to date.
+    /// \see getContentHash()
+    mutable unsigned contentHash;
+    mutable std::set<const MemoryObject*> changedObjects;
+
+    static unsigned hashBinding(const MemoryObject *mo,
+                                const ObjectState *os);
+
     /// Unsupported, use copy constructor
     AddressSpace &operator=(const AddressSpace&); 
     
@@ -52,8 +63,10 @@ namespace klee {
     MemoryMap objects;
     
   public:
-    AddressSpace() : cowKey(1) {}
-    AddressSpace(const AddressSpace &b) : cowKey(++b.cowKey), objects(b.objects) { }
+    AddressSpace() : cowKey(1), contentHash(0) {}
+    AddressSpace(const AddressSpace &b)
+      : cowKey(++b.cowKey), contentHash(b.contentHash),
+        changedObjects(b.changedObjects), objects(b.objects) { }
     ~AddressSpace() {}
 
     /// Resolve address to an ObjectPair in result.
@@ -125,6 +138,12 @@ namespace klee {
     /// \retval true The copy succeeded. 
     /// \retval false The copy failed because a read-only object was modified.
     bool copyInConcretes();
+
+    /// Return a hash of the bindings and the contents of the objects, such
+    /// that address spaces with the same contents have the same hash. The
+    /// hashes of the bindings are summed, so only those of the objects
+    /// bound or made writeable since the last call are computed again.
+    unsigned getContentHash() const;
   };
 } // End klee namespace
 
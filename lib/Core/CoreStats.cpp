@@ -12,6 +12,8 @@
 using namespace klee;
 
 Statistic stats::allocations("Allocations", "Alloc");
+Statistic stats::boundsCheckQueryTimeouts("BoundsCheckQueryTimeouts", "BQto");
+Statistic stats::branchQueryTimeouts("BranchQueryTimeouts", "BrQto");
 Statistic stats::coveredInstructions("CoveredInstructions", "Icov");
 Statistic stats::falseBranches("FalseBranches", "Bf");
 Statistic stats::forkTime("ForkTime", "Ftime");
@@ -21,9 +23,14 @@ Statistic stats::instructionTime("InstructionTimes", "Itime");
 Statistic stats::instructions("Instructions", "I");
 Statistic stats::minDistToReturn("MinDistToReturn", "Rdist");
 Statistic stats::minDistToUncovered("MinDistToUncovered", "UCdist");
+Statistic stats::otherQueryTimeouts("OtherQueryTimeouts", "OQto");
 Statistic stats::reachableUncovered("ReachableUncovered", "IuncovReach");
 Statistic stats::resolveTime("ResolveTime", "Rtime");
 Statistic stats::solverTime("SolverTime", "Stime");
 Statistic stats::states("States", "States");
+Statistic stats::statesMerged("StatesMerged", "Merged");
+Statistic stats::statesShared("StatesShared", "Shared");
+Statistic stats::statesSubsumed("StatesSubsumed", "Subsumed");
+Statistic stats::testGenQueryTimeouts("TestGenQueryTimeouts", "TGQto");
 Statistic stats::trueBranches("TrueBranches", "Bt");
 Statistic stats::uncoveredInstructions("UncoveredInstructions", "Iuncov");
@@ -27,6 +27,13 @@ namespace stats {
   extern Statistic forkTime;
   extern Statistic solverTime;
 
+  /// The number of solver queries which failed (usually by timing out),
+  /// for each class of queries.
+  extern Statistic branchQueryTimeouts;
+  extern Statistic boundsCheckQueryTimeouts;
+  extern Statistic testGenQueryTimeouts;
+  extern Statistic otherQueryTimeouts;
+
   /// The number of process forks.
   extern Statistic forks;
 
@@ -34,6 +41,17 @@ namespace stats {
   /// isn't normally up-to-date.
   extern Statistic states;
 
+  /// The number of states merged into another state (see --auto-merge).
+  extern Statistic statesMerged;
+
+  /// The number of states handed over to the work queue, in distributed
+  /// mode.
+  extern Statistic statesShared;
+
+  /// The number of states terminated because they were subsumed by an
+  /// earlier state (see --use-state-subsumption).
+  extern Statistic statesSubsumed;
+
   /// Instruction level statistic for tracking number of reachable
   /// uncovered instructions.
   extern Statistic reachableUncovered;
@@ -54,7 +54,8 @@ StackFrame::StackFrame(const StackFrame &s)
     callPathNode(s.callPathNode),
     allocas(s.allocas),
     minDistToUncoveredOnReturn(s.minDistToUncoveredOnReturn),
-    varargs(s.varargs) {
+    varargs(s.varargs),
+    loopIterations(s.loopIterations) {
   locals = new Cell[s.kf->numRegisters];
   for (unsigned i=0; i<s.kf->numRegisters; i++)
     locals[i] = s.locals[i];
@@ -66,6 +67,24 @@ StackFrame::~StackFrame() {
 
 /***/
 
+namespace {
+  /// Ids of destroyed states, available for reuse.
+  std::vector<unsigned> freeStateIds;
+  unsigned nextStateId = 0;
+}
+
+unsigned ExecutionState::allocateId() {
+  if (freeStateIds.empty())
+    return nextStateId++;
+  unsigned id = freeStateIds.back();
+  freeStateIds.pop_back();
+  return id;
+}
+
+void ExecutionState::releaseId(unsigned id) {
+  freeStateIds.push_back(id);
+}
+
 ExecutionState::ExecutionState(KFunction *kf) :
     pc(kf->instructions),
     prevPC(pc),
@@ -76,15 +95,21 @@ ExecutionState::ExecutionState(KFunction *kf) :
 
     instsSinceCovNew(0),
     coveredNew(false),
+    coverageEpoch(0),
     forkDisabled(false),
-    ptreeNode(0) {
+    replayable(true),
+    ptreeNode(0),
+    id(allocateId()) {
   pushFrame(0, kf);
 }
 
 ExecutionState::ExecutionState(const std::vector<ref<Expr> > &assumptions)
-    : constraints(assumptions), queryCost(0.), ptreeNode(0) {}
+    : constraints(assumptions), queryCost(0.), ptreeNode(0),
+      id(allocateId()) {}
 
 ExecutionState::~ExecutionState() {
+  releaseId(id);
+
   for (unsigned int i=0; i<symbolics.size(); i++)
   {
     const MemoryObject *mo = symbolics[i].first;
@@ -116,11 +141,15 @@ ExecutionState::ExecutionState(const ExecutionState& state):
 
     instsSinceCovNew(state.instsSinceCovNew),
     coveredNew(state.coveredNew),
+    coverageEpoch(state.coverageEpoch),
     forkDisabled(state.forkDisabled),
+    replayable(state.replayable),
+    forkChoices(state.forkChoices),
     coveredLines(state.coveredLines),
     ptreeNode(state.ptreeNode),
     symbolics(state.symbolics),
-    arrayNames(state.arrayNames)
+    arrayNames(state.arrayNames),
+    id(allocateId())
 {
   for (unsigned int i=0; i<symbolics.size(); i++)
     symbolics[i].first->refCount++;
@@ -18,7 +18,9 @@
 #include "Searcher.h"
 #include "SeedInfo.h"
 #include "SpecialFunctionHandler.h"
+#include "StateMerger.h"
 #include "StatsTracker.h"
+#include "SubsumptionChecker.h"
 #include "TimingSolver.h"
 #include "UserSearcher.h"
 #include "ExecutorTimerInfo.h"
@@ -44,6 +46,7 @@
 #include "klee/Internal/Module/KModule.h"
 #include "klee/Internal/Support/ErrorHandling.h"
 #include "klee/Internal/Support/FloatEvaluation.h"
+#include "klee/Internal/Support/WorkQueue.h"
 #include "klee/Internal/System/Time.h"
 #include "klee/Internal/System/MemoryUsage.h"
 #include "klee/SolverStats.h"
@@ -90,7 +93,11 @@
 #endif
 
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <algorithm>
+#include <deque>
 #include <iomanip>
 #include <iosfwd>
 #include <fstream>
@@ -106,6 +113,7 @@
 using namespace llvm;
 using namespace klee;
 
+extern cl::opt<double> CheckpointInterval;
 
 
 
@@ -237,6 +245,16 @@ namespace {
 		    cl::init(false),
                     cl::desc("Use names to match symbolic objects to inputs (default=off)."));
 
+  cl::opt<bool>
+  OutputLoopForks("output-loop-forks",
+                  cl::init(false),
+                  cl::desc("Write the number of forks within each loop to loop-forks.txt (default=off)."));
+
+  cl::opt<bool>
+  Concolic("concolic",
+           cl::init(false),
+           cl::desc("Execute one input at a time, starting from the seeds (or zeros), following it without querying the solver at branches, and generate new inputs by negating the branches taken (default=off)."));
+
   cl::opt<double>
   MaxStaticForkPct("max-static-fork-pct", 
 		   cl::init(1.),
@@ -291,6 +309,46 @@ namespace {
   MaxMemoryInhibit("max-memory-inhibit",
             cl::desc("Inhibit forking at memory cap (vs. random terminate) (default=on)"),
             cl::init(true));
+
+  cl::opt<bool>
+  UseStateSubsumption("use-state-subsumption",
+                      cl::desc("Terminate the states reaching a loop header with the same stack and memory as an earlier state, and constraints implying its constraints (default=off)"),
+                      cl::init(false));
+
+  cl::opt<unsigned>
+  MaxSubsumptionSnapshots("max-subsumption-snapshots",
+                          cl::desc("Number of earlier states remembered by --use-state-subsumption (default=1024)"),
+                          cl::init(1024));
+
+  cl::opt<bool>
+  AutoMerge("auto-merge",
+            cl::desc("Merge the states forked at a branch when they reach its post-dominator, for small regions without calls (default=off)"),
+            cl::init(false));
+
+  cl::opt<unsigned>
+  AutoMergeMaxRegionSize("auto-merge-max-region-size",
+                         cl::desc("Maximum number of instructions between a branch and its post-dominator for --auto-merge (default=64)"),
+                         cl::init(64));
+
+  cl::opt<unsigned>
+  AutoMergeMaxCost("auto-merge-max-cost",
+                   cl::desc("Maximum number of registers and memory bytes which differ between two states merged by --auto-merge (default=32)"),
+                   cl::init(32));
+
+  cl::opt<bool>
+  OutputCoverage("output-coverage",
+                 cl::init(false),
+                 cl::desc("Write the source lines covered to coverage.txt (default=off)."));
+
+  cl::opt<double>
+  DistShareInterval("dist-share-interval",
+                    cl::desc("Seconds between checks of the work queue for handing over states, in distributed mode (default=1.0)"),
+                    cl::init(1.0));
+
+  cl::opt<unsigned>
+  DistMaxPending("dist-max-pending",
+                 cl::desc("Only hand over states to the work queue while it holds fewer jobs than this, in distributed mode (default=2)"),
+                 cl::init(2));
 }
 
 
@@ -302,15 +360,27 @@ Executor::Executor(const InterpreterOptions &opts, InterpreterHandler *ih)
     : Interpreter(opts), kmodule(0), interpreterHandler(ih), searcher(0),
       externalDispatcher(new ExternalDispatcher()), statsTracker(0),
       pathWriter(0), symPathWriter(0), specialFunctionHandler(0),
-      processTree(0), replayKTest(0), replayPath(0), usingSeeds(0),
+      processTree(0), subsumptionChecker(0), stateMerger(0), resumeTree(0),
+      replayKTest(0), replayPath(0), usingSeeds(0), workQueue(0),
+      nextShareTime(0),
       atMemoryLimit(false), inhibitForking(false), haltExecution(false),
-      ivcEnabled(false),
-      coreSolverTimeout(MaxCoreSolverTime != 0 && MaxInstructionTime != 0
-                            ? std::min(MaxCoreSolverTime, MaxInstructionTime)
-                            : std::max(MaxCoreSolverTime, MaxInstructionTime)),
+      ivcEnabled(false), coreSolverTimeout(0), solverTimeouts(0),
       debugInstFile(0), debugLogBuffer(debugBufferString) {
 
-  if (coreSolverTimeout) UseForkedCoreSolver = true;
+  createSolver();
+  memory = new MemoryManager(&arrayCache);
+  openDebugInstFile();
+}
+
+void Executor::createSolver() {
+  // The timeouts are set along with the solver, so the options of a fork
+  // server job apply to it.
+  coreSolverTimeout = MaxCoreSolverTime != 0 && MaxInstructionTime != 0
+                        ? std::min(MaxCoreSolverTime, MaxInstructionTime)
+                        : std::max(MaxCoreSolverTime, MaxInstructionTime);
+  solverTimeouts = SolverTimeouts(coreSolverTimeout);
+  if (solverTimeouts.hasTimeouts()) UseForkedCoreSolver = true;
+
   Solver *coreSolver = klee::createCoreSolver(CoreSolverToUse);
   if (!coreSolver) {
     llvm::errs() << "Failed to create core solver\n";
@@ -324,8 +394,9 @@ Executor::Executor(const InterpreterOptions &opts, InterpreterHandler *ih)
       interpreterHandler->getOutputFilename(SOLVER_QUERIES_PC_FILE_NAME));
 
   this->solver = new TimingSolver(solver, EqualitySubstitution);
-  memory = new MemoryManager(&arrayCache);
+}
 
+void Executor::openDebugInstFile() {
   if (optionIsSet(DebugPrintInstructions, FILE_ALL) ||
       optionIsSet(DebugPrintInstructions, FILE_COMPACT) ||
       optionIsSet(DebugPrintInstructions, FILE_SRC)) {
@@ -364,14 +435,12 @@ const Module *Executor::setModule(llvm::Module *module,
   kmodule->prepare(opts, interpreterHandler);
   specialFunctionHandler->bind();
 
-  if (StatsTracker::useStatistics()) {
-    statsTracker = 
-      new StatsTracker(*this,
-                       interpreterHandler->getOutputFilename("assembly.ll"),
-                       userSearcherRequiresMD2U());
-  }
-  
-  return module;
+  // The statistics are only tracked from the first run, so the output
+  // directory can still change until then (see setInterpreterHandler).
+  assemblyFilename = interpreterHandler->getOutputFilename("assembly.ll");
+
+  // The module is replaced when it is loaded from the module cache.
+  return kmodule->module;
 }
 
 Executor::~Executor() {
@@ -383,8 +452,13 @@ Executor::~Executor() {
     delete specialFunctionHandler;
   if (statsTracker)
     delete statsTracker;
+  if (subsumptionChecker)
+    delete subsumptionChecker;
+  if (stateMerger)
+    delete stateMerger;
   delete solver;
   delete kmodule;
+  delete resumeTree;
   while(!timers.empty()) {
     delete timers.back();
     timers.pop_back();
@@ -625,8 +699,51 @@ void Executor::branch(ExecutionState &state,
   unsigned N = conditions.size();
   assert(N);
 
+  // As in fork(), the choice of the target is recorded, and the resumed
+  // states only take the targets leading to the saved paths.
+  ResumeNode *resumeNode = 0;
+  if (N > 1) {
+    std::map<ExecutionState*, ResumeNode*>::iterator rit =
+      resumeMap.find(&state);
+    if (rit != resumeMap.end())
+      resumeNode = rit->second;
+  }
+
+  std::map< ExecutionState*, std::vector<SeedInfo> >::iterator sit =
+    seedMap.find(&state);
+  if (Concolic && sit != seedMap.end()) {
+    // Follow the input, as in fork().
+    unsigned next = N;
+    for (unsigned i=0; i<N && next==N; ++i) {
+      ref<Expr> value = sit->second[0].assignment.evaluate(conditions[i]);
+      if (ConstantExpr *CE = dyn_cast<ConstantExpr>(value)) {
+        if (CE->isTrue())
+          next = i;
+      } else {
+        bool res;
+        bool success = solver->mayBeTrue(state, conditions[i], res);
+        assert(success && "FIXME: Unhandled solver failure");
+        (void) success;
+        if (res)
+          next = i;
+      }
+    }
+    assert(next != N && "no feasible branch");
+
+    for (unsigned i=0; i<N; ++i)
+      result.push_back(i == next ? &state : NULL);
+    if (N > 1)
+      recordForkChoice(state, resumeNode, next);
+    if (!isa<ConstantExpr>(conditions[next]))
+      concolicPath.push_back(conditions[next]);
+    addConstraint(state, conditions[next]);
+    return;
+  }
+
   if (MaxForks!=~0u && stats::forks >= MaxForks) {
     unsigned next = theRNG.getInt32() % N;
+    if (resumeNode && !resumeNode->children.empty())
+      next = resumeNode->children.begin()->first % N;
     for (unsigned i=0; i<N; ++i) {
       if (i == next) {
         result.push_back(&state);
@@ -634,8 +751,11 @@ void Executor::branch(ExecutionState &state,
         result.push_back(NULL);
       }
     }
+    if (N > 1)
+      recordForkChoice(state, resumeNode, next);
   } else {
     stats::forks += N-1;
+    countLoopForks(state, N-1);
 
     // XXX do proper balance or keep random?
     result.push_back(&state);
@@ -650,6 +770,26 @@ void Executor::branch(ExecutionState &state,
       ns->ptreeNode = res.first;
       es->ptreeNode = res.second;
     }
+
+    // The choice among the N targets is not recorded in the path.
+    for (unsigned i=0; i<N; ++i)
+      result[i]->replayable = false;
+
+    if (N > 1) {
+      for (unsigned i=0; i<N; ++i)
+        recordForkChoice(*result[i], resumeNode, i);
+
+      // The targets which are not on a saved path were explored before the
+      // checkpoint.
+      if (resumeNode) {
+        for (unsigned i=0; i<N; ++i) {
+          if (!resumeNode->getChild(i)) {
+            terminateState(*result[i]);
+            result[i] = NULL;
+          }
+        }
+      }
+    }
   }
 
   // If necessary redistribute seeds to match conditions, killing
@@ -711,7 +851,38 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
     seedMap.find(&current);
   bool isSeeding = it != seedMap.end();
 
-  if (!isSeeding && !isa<ConstantExpr>(condition) && 
+  if (Concolic && isSeeding && !isa<ConstantExpr>(condition)) {
+    // Follow the input; the other side is explored by a later run, on an
+    // input generated by negating the recorded condition.
+    ref<Expr> value = it->second[0].assignment.evaluate(condition);
+    if (!isa<ConstantExpr>(value)) {
+      ref<ConstantExpr> res;
+      bool success = solver->getValue(current, condition, res);
+      assert(success && "FIXME: Unhandled solver failure");
+      (void) success;
+      value = res;
+    }
+
+    bool isTrue = cast<ConstantExpr>(value)->isTrue();
+    ref<Expr> taken = isTrue ? condition : Expr::createIsZero(condition);
+    concolicPath.push_back(taken);
+    addConstraint(current, taken);
+    return isTrue ? StatePair(&current, 0) : StatePair(0, &current);
+  }
+
+  // Every fork on a symbolic condition is recorded, with whether the other
+  // side was feasible, so that the resumed states follow the saved paths
+  // without asking the solver. \see ExecutionState::forkChoices
+  bool isChoice = !isa<ConstantExpr>(condition);
+  ResumeNode *resumeNode = 0;
+  if (isChoice) {
+    std::map<ExecutionState*, ResumeNode*>::iterator rit =
+      resumeMap.find(&current);
+    if (rit != resumeMap.end())
+      resumeNode = rit->second;
+  }
+
+  if (!isSeeding && !resumeNode && !isa<ConstantExpr>(condition) && 
       (MaxStaticForkPct!=1. || MaxStaticSolvePct != 1. ||
        MaxStaticCPForkPct!=1. || MaxStaticCPSolvePct != 1.) &&
       statsTracker->elapsed() > 60.) {
@@ -738,20 +909,45 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
     }
   }
 
-  double timeout = coreSolverTimeout;
-  if (isSeeding)
-    timeout *= it->second.size();
-  solver->setTimeout(timeout);
-  bool success = solver->evaluate(current, condition, res);
-  solver->setTimeout(0);
-  if (!success) {
-    current.pc = current.prevPC;
-    terminateStateEarly(current, "Query timed out (fork).");
-    return StatePair(0, 0);
+  bool bothFeasible;
+  if (resumeNode) {
+    // The sides on the saved paths are known to be feasible. A side taken
+    // by choice is constrained as it was before the checkpoint.
+    if (resumeNode->children.size() != 1) {
+      res = Solver::Unknown;
+      bothFeasible = true;
+    } else {
+      unsigned choice = resumeNode->children.begin()->first;
+      res = choice & 1 ? Solver::True : Solver::False;
+      bothFeasible = choice < 2;
+      if (bothFeasible)
+        addConstraint(current,
+                      choice ? condition : Expr::createIsZero(condition));
+    }
+  } else {
+    double timeout = solverTimeouts.getTimeout(SolverTimeouts::Branch);
+    if (isSeeding)
+      timeout *= it->second.size();
+    double queryStart = util::getWallTime();
+    solver->setTimeout(timeout);
+    bool success = solver->evaluate(current, condition, res);
+    solver->setTimeout(0);
+    solverTimeouts.recordQuery(SolverTimeouts::Branch,
+                               util::getWallTime() - queryStart,
+                               !success && solver->hasTimedOut());
+    if (!success) {
+      current.pc = current.prevPC;
+      terminateStateEarly(current, "Query timed out (fork).");
+      return StatePair(0, 0);
+    }
+    bothFeasible = res == Solver::Unknown;
   }
 
-  if (!isSeeding) {
-    if (replayPath && !isInternal) {
+  if (!isSeeding && !resumeNode) {
+    if (replayPath && !isInternal &&
+        (!workQueue || replayPosition < replayPath->size())) {
+      // With a work queue, the replay path is only a prefix; past it the
+      // subtree below is explored as usual.
       assert(replayPosition<replayPath->size() &&
              "ran out of branches in replay path mode");
       bool branch = (*replayPath)[replayPosition++];
@@ -843,6 +1039,8 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
         current.pathOS << "1";
       }
     }
+    if (isChoice)
+      recordForkChoice(current, resumeNode, bothFeasible ? 1 : 3);
 
     return StatePair(&current, 0);
   } else if (res==Solver::False) {
@@ -851,6 +1049,8 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
         current.pathOS << "0";
       }
     }
+    if (isChoice)
+      recordForkChoice(current, resumeNode, bothFeasible ? 0 : 2);
 
     return StatePair(0, &current);
   } else {
@@ -858,29 +1058,38 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
     ExecutionState *falseState, *trueState = &current;
 
     ++stats::forks;
+    countLoopForks(current, 1);
 
     falseState = trueState->branch();
     addedStates.insert(falseState);
+    if (isInternal)
+      trueState->replayable = falseState->replayable = false;
 
     if (RandomizeFork && theRNG.getBool())
       std::swap(trueState, falseState);
 
+    recordForkChoice(*trueState, resumeNode, 1);
+    recordForkChoice(*falseState, resumeNode, 0);
+
     if (it != seedMap.end()) {
       std::vector<SeedInfo> seeds = it->second;
       it->second.clear();
       std::vector<SeedInfo> &trueSeeds = seedMap[trueState];
       std::vector<SeedInfo> &falseSeeds = seedMap[falseState];
+      std::vector< ref<Expr> > seedConditions;
       for (std::vector<SeedInfo>::iterator siit = seeds.begin(), 
-             siie = seeds.end(); siit != siie; ++siit) {
-        ref<ConstantExpr> res;
-        bool success = 
-          solver->getValue(current, siit->assignment.evaluate(condition), res);
-        assert(success && "FIXME: Unhandled solver failure");
-        (void) success;
-        if (res->isTrue()) {
-          trueSeeds.push_back(*siit);
+             siie = seeds.end(); siit != siie; ++siit)
+        seedConditions.push_back(siit->assignment.evaluate(condition));
+
+      std::vector< ref<ConstantExpr> > seedResults;
+      bool success = solver->getValues(current, seedConditions, seedResults);
+      assert(success && "FIXME: Unhandled solver failure");
+      (void) success;
+      for (unsigned i = 0, e = seeds.size(); i != e; ++i) {
+        if (seedResults[i]->isTrue()) {
+          trueSeeds.push_back(seeds[i]);
         } else {
-          falseSeeds.push_back(*siit);
+          falseSeeds.push_back(seeds[i]);
         }
       }
       
@@ -1062,14 +1271,17 @@ ref<Expr> Executor::toUnique(const ExecutionState &state,
 
   if (!isa<ConstantExpr>(e)) {
     ref<ConstantExpr> value;
-    bool isTrue = false;
+    bool isUnique = false;
 
-    solver->setTimeout(coreSolverTimeout);      
-    if (solver->getValue(state, e, value) &&
-        solver->mustBeTrue(state, EqExpr::create(e, value), isTrue) &&
-        isTrue)
-      result = value;
+    double queryStart = util::getWallTime();
+    solver->setTimeout(solverTimeouts.getTimeout(SolverTimeouts::Other));
+    bool success = solver->getUniqueValue(state, e, value, isUnique);
     solver->setTimeout(0);
+    solverTimeouts.recordQuery(SolverTimeouts::Other,
+                               util::getWallTime() - queryStart,
+                               !success && solver->hasTimedOut());
+    if (success && isUnique)
+      result = value;
   }
   
   return result;
@@ -1120,16 +1332,17 @@ void Executor::executeGetValue(ExecutionState &state,
     (void) success;
     bindLocal(target, state, value);
   } else {
-    std::set< ref<Expr> > values;
+    // Ask for the values under all seeds in a single query.
+    std::vector< ref<Expr> > seedExprs;
     for (std::vector<SeedInfo>::iterator siit = it->second.begin(), 
-           siie = it->second.end(); siit != siie; ++siit) {
-      ref<ConstantExpr> value;
-      bool success = 
-        solver->getValue(state, siit->assignment.evaluate(e), value);
-      assert(success && "FIXME: Unhandled solver failure");
-      (void) success;
-      values.insert(value);
-    }
+           siie = it->second.end(); siit != siie; ++siit)
+      seedExprs.push_back(siit->assignment.evaluate(e));
+
+    std::vector< ref<ConstantExpr> > seedValues;
+    bool success = solver->getValues(state, seedExprs, seedValues);
+    assert(success && "FIXME: Unhandled solver failure");
+    (void) success;
+    std::set< ref<Expr> > values(seedValues.begin(), seedValues.end());
     
     std::vector< ref<Expr> > conditions;
     for (std::set< ref<Expr> >::iterator vit = values.begin(), 
@@ -1378,6 +1591,151 @@ void Executor::transferToBasicBlock(BasicBlock *dst, BasicBlock *src,
     PHINode *first = static_cast<PHINode*>(state.pc->inst);
     state.incomingBBIndex = first->getBasicBlockIndex(src);
   }
+
+  // Count the iterations of a loop since it was entered.
+  std::map<BasicBlock*, BasicBlock*>::iterator it = kf->loopHeaders.find(dst);
+  if (it != kf->loopHeaders.end() && it->second == dst) {
+    unsigned &iterations = state.stack.back().loopIterations[dst];
+    if (kf->backEdges.count(std::make_pair(src, dst)))
+      ++iterations;
+    else
+      iterations = 0;
+  }
+}
+
+void Executor::countLoopForks(ExecutionState &state, unsigned forks) {
+  KFunction *kf = state.stack.back().kf;
+  std::map<BasicBlock*, BasicBlock*>::iterator it =
+    kf->loopHeaders.find(state.prevPC->inst->getParent());
+  if (it != kf->loopHeaders.end())
+    kf->loopForks[it->second] += forks;
+}
+
+void Executor::dumpLoopForks() {
+  std::vector< std::pair<uint64_t, std::pair<KFunction*, BasicBlock*> > >
+    loops;
+  for (std::vector<KFunction*>::iterator it = kmodule->functions.begin(),
+         ie = kmodule->functions.end(); it != ie; ++it)
+    for (std::map<BasicBlock*, uint64_t>::iterator
+           lit = (*it)->loopForks.begin(), lie = (*it)->loopForks.end();
+         lit != lie; ++lit)
+      loops.push_back(std::make_pair(lit->second,
+                                     std::make_pair(*it, lit->first)));
+  std::sort(loops.rbegin(), loops.rend());
+
+  llvm::raw_ostream *os = interpreterHandler->openOutputFile("loop-forks.txt");
+  if (!os)
+    return;
+  *os << "# forks\tfunction\tloop header\n";
+  for (unsigned i = 0; i < loops.size(); ++i) {
+    KFunction *kf = loops[i].second.first;
+    KInstruction *ki =
+      kf->instructions[kf->basicBlockEntry[loops[i].second.second]];
+    *os << loops[i].first << "\t" << kf->function->getName() << "\t"
+        << ki->info->file << ":" << ki->info->line << "\n";
+  }
+  delete os;
+}
+
+bool Executor::isSubsumed(ExecutionState &state, KInstruction *ki) {
+  // Only check states which just entered a loop header.
+  BasicBlock *bb = ki->inst->getParent();
+  if (ki->inst != &bb->front() || !subsumptionChecker->isCheckPoint(bb))
+    return false;
+
+  std::vector< ref<Expr> > conditions;
+  subsumptionChecker->findCandidates(state, conditions);
+  for (std::vector< ref<Expr> >::iterator it = conditions.begin(),
+         ie = conditions.end(); it != ie; ++it) {
+    if (ConstantExpr *CE = dyn_cast<ConstantExpr>(*it)) {
+      if (CE->isTrue())
+        return true;
+      continue;
+    }
+
+    double queryStart = util::getWallTime();
+    solver->setTimeout(solverTimeouts.getTimeout(SolverTimeouts::Other));
+    bool res;
+    bool success = solver->mustBeTrue(state, *it, res);
+    solver->setTimeout(0);
+    solverTimeouts.recordQuery(SolverTimeouts::Other,
+                               util::getWallTime() - queryStart,
+                               !success && solver->hasTimedOut());
+    if (success && res)
+      return true;
+  }
+
+  subsumptionChecker->record(state);
+  return false;
+}
+
+void Executor::mergeBranches(BasicBlock *bb, ExecutionState &a,
+                             ExecutionState &b) {
+  // A merged state does not follow a single path, so there is nothing to
+  // replay or record for it.
+  if (replayPath || replayKTest || !seedMap.empty() ||
+      pathWriter || symPathWriter)
+    return;
+
+  const StateMerger::Region *region = stateMerger->getRegion(bb);
+  if (!region)
+    return;
+
+  // Run the states until they reach the merge point or leave the region
+  // (in which case they are left to the searcher). States created during
+  // the current step are deleted as soon as they terminate, so they are
+  // only compared by address.
+  std::vector<ExecutionState*> pending, arrived;
+  pending.push_back(&a);
+  pending.push_back(&b);
+  while (!pending.empty() && !haltExecution) {
+    ExecutionState *es = pending.back();
+    pending.pop_back();
+
+    Instruction *inst = es->pc->inst;
+    if (inst == region->mergePoint) {
+      arrived.push_back(es);
+      continue;
+    }
+    if (!region->blocks.count(inst->getParent()))
+      continue;
+
+    bool isAdded = addedStates.count(es);
+    std::set<ExecutionState*> before(addedStates.begin(), addedStates.end());
+    KInstruction *ki = es->pc;
+    stepInstruction(*es);
+    executeInstruction(*es, ki);
+
+    std::set<ExecutionState*> after(addedStates.begin(), addedStates.end());
+    for (std::set<ExecutionState*>::iterator it = after.begin(),
+           ie = after.end(); it != ie; ++it)
+      if (!before.count(*it))
+        pending.push_back(*it);
+    if (isAdded ? after.count(es) : !removedStates.count(es))
+      pending.push_back(es);
+  }
+
+  for (unsigned i = 0; i < arrived.size(); ++i) {
+    ExecutionState *base = arrived[i];
+    if (!base)
+      continue;
+    for (unsigned j = i + 1; j < arrived.size(); ++j) {
+      ExecutionState *other = arrived[j];
+      if (!other || !stateMerger->shouldMerge(*base, *other) ||
+          !base->merge(*other))
+        continue;
+
+      base->coveredNew |= other->coveredNew;
+      for (std::map<const std::string*, std::set<unsigned> >::iterator
+             it = other->coveredLines.begin(), ie = other->coveredLines.end();
+           it != ie; ++it)
+        base->coveredLines[it->first].insert(it->second.begin(),
+                                             it->second.end());
+      ++stats::statesMerged;
+      terminateState(*other);
+      arrived[j] = 0;
+    }
+  }
 }
 
 void Executor::printFileLine(ExecutionState &state, KInstruction *ki,
@@ -1564,6 +1922,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
         transferToBasicBlock(bi->getSuccessor(0), bi->getParent(), *branches.first);
       if (branches.second)
         transferToBasicBlock(bi->getSuccessor(1), bi->getParent(), *branches.second);
+
+      if (stateMerger && branches.first && branches.second)
+        mergeBranches(bi->getParent(), *branches.first, *branches.second);
     }
     break;
   }
@@ -2439,27 +2800,31 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
 void Executor::updateStates(ExecutionState *current) {
   if (searcher) {
-    searcher->update(current, addedStates, removedStates);
+    searcher->update(current, addedStates.getStates(),
+                     removedStates.getStates());
   }
   
   states.insert(addedStates.begin(), addedStates.end());
   addedStates.clear();
   
-  for (std::set<ExecutionState*>::iterator
-         it = removedStates.begin(), ie = removedStates.end();
-       it != ie; ++it) {
+  // The set is emptied before the states are deleted, as emptying it reads
+  // their ids.
+  removedStates.take(statesToDelete);
+  for (std::vector<ExecutionState*>::iterator it = statesToDelete.begin(),
+         ie = statesToDelete.end(); it != ie; ++it) {
     ExecutionState *es = *it;
-    std::set<ExecutionState*>::iterator it2 = states.find(es);
-    assert(it2!=states.end());
-    states.erase(it2);
+    bool wasLive = states.erase(es);
+    assert(wasLive && "removed state is not live");
+    (void) wasLive;
     std::map<ExecutionState*, std::vector<SeedInfo> >::iterator it3 = 
       seedMap.find(es);
     if (it3 != seedMap.end())
       seedMap.erase(it3);
+    resumeMap.erase(es);
     processTree->remove(es->ptreeNode);
     delete es;
   }
-  removedStates.clear();
+  statesToDelete.clear();
 }
 
 template <typename TypeIt>
@@ -2564,6 +2929,11 @@ void Executor::run(ExecutionState &initialState) {
   // optimization and such.
   initTimers();
 
+  if (Concolic) {
+    runConcolic(initialState);
+    return;
+  }
+
   states.insert(&initialState);
 
   if (usingSeeds) {
@@ -2610,17 +2980,17 @@ void Executor::run(ExecutionState &initialState) {
                    time >= lastTime+10) {
           lastTime = time;
           lastNumSeeds = numSeeds;          
-          klee_message("%d seeds remaining over: %d states", 
-                       numSeeds, numStates);
+          reportSeedingProgress(numSeeds, numStates, time - startTime);
         }
       }
     }
 
+    reportSeedingProgress(0, 0, util::getWallTime() - startTime);
     klee_message("seeding done (%d states remain)", (int) states.size());
 
     // XXX total hack, just because I like non uniform better but want
     // seed results to be equally weighted.
-    for (std::set<ExecutionState*>::iterator
+    for (StateSet::const_iterator
            it = states.begin(), ie = states.end();
          it != ie; ++it) {
       (*it)->weight = 1.;
@@ -2632,17 +3002,25 @@ void Executor::run(ExecutionState &initialState) {
 
   searcher = constructUserSearcher(*this);
 
-  searcher->update(0, states, std::set<ExecutionState*>());
+  searcher->update(0, states.getStates(), std::vector<ExecutionState*>());
 
   while (!states.empty() && !haltExecution) {
     ExecutionState &state = searcher->selectState();
     KInstruction *ki = state.pc;
+    if (subsumptionChecker && isSubsumed(state, ki)) {
+      ++stats::statesSubsumed;
+      terminateState(state);
+      updateStates(&state);
+      continue;
+    }
     stepInstruction(state);
 
     executeInstruction(state, ki);
     processTimers(&state, MaxInstructionTime);
 
     checkMemoryUsage();
+    if (workQueue)
+      shareWork(state);
 
     updateStates(&state);
   }
@@ -2651,9 +3029,13 @@ void Executor::run(ExecutionState &initialState) {
   searcher = 0;
   
  dump:
+  // Save whatever is left, in particular when halted before the end.
+  if (CheckpointInterval)
+    checkpoint();
+
   if (DumpStatesOnHalt && !states.empty()) {
     llvm::errs() << "KLEE: halting execution, dumping remaining states\n";
-    for (std::set<ExecutionState*>::iterator
+    for (StateSet::const_iterator
            it = states.begin(), ie = states.end();
          it != ie; ++it) {
       ExecutionState &state = **it;
@@ -2662,6 +3044,226 @@ void Executor::run(ExecutionState &initialState) {
     }
     updateStates(0);
   }
+
+  if (OutputLoopForks)
+    dumpLoopForks();
+  if (OutputCoverage)
+    dumpCoverage();
+}
+
+void Executor::reportSeedingProgress(unsigned numSeeds, unsigned numStates,
+                                     double elapsed) {
+  char line[256];
+  snprintf(line, sizeof(line),
+           "%u/%u seeds done, %u remaining over %u states, %.0fs",
+           (unsigned) usingSeeds->size() - numSeeds,
+           (unsigned) usingSeeds->size(), numSeeds, numStates, elapsed);
+  klee_message("seeding: %s", line);
+
+  // Kept up to date for whoever watches the progress from outside (see
+  // --seed-workers).
+  llvm::raw_ostream *os = interpreterHandler->openOutputFile("seeding.txt");
+  if (os) {
+    *os << line << "\n";
+    delete os;
+  }
+}
+
+void Executor::setInterpreterHandler(InterpreterHandler *ih) {
+  assert(!statsTracker && "output directory changed after the first run");
+  interpreterHandler = ih;
+
+  // Reopen the logs in the new output directory.
+  delete solver;
+  createSolver();
+  if (debugInstFile) {
+    delete debugInstFile;
+    debugInstFile = 0;
+    openDebugInstFile();
+  }
+}
+
+void Executor::shareWork(ExecutionState &current) {
+  double now = util::getWallTime();
+  if (now < nextShareTime)
+    return;
+  nextShareTime = now + DistShareInterval;
+
+  if (states.size() < 2 || workQueue->getNumPending() >= DistMaxPending)
+    return;
+
+  // Hand over the shallowest state, whose subtree is likely the largest.
+  ExecutionState *shared = 0;
+  for (StateSet::const_iterator it = states.begin(), ie = states.end();
+       it != ie; ++it) {
+    ExecutionState *es = *it;
+    if (es == &current || !es->replayable || seedMap.count(es) ||
+        removedStates.count(es))
+      continue;
+    if (!shared || es->depth < shared->depth)
+      shared = es;
+  }
+  if (!shared)
+    return;
+
+  std::vector<unsigned char> branches;
+  pathWriter->readStream(getPathStreamID(*shared), branches);
+  std::vector<bool> path;
+  for (std::vector<unsigned char>::iterator it = branches.begin(),
+         ie = branches.end(); it != ie; ++it)
+    path.push_back(*it == '1');
+  if (!workQueue->push(path)) {
+    klee_warning("unable to write to the work queue");
+    return;
+  }
+
+  ++stats::statesShared;
+  terminateState(*shared);
+}
+
+void Executor::setResumeNode(ExecutionState &state, ResumeNode *node) {
+  if (node && !node->end)
+    resumeMap[&state] = node;
+  else
+    resumeMap.erase(&state);
+}
+
+void Executor::recordForkChoice(ExecutionState &state, ResumeNode *resumeNode,
+                                unsigned choice) {
+  if (CheckpointInterval)
+    state.forkChoices.push_back(choice);
+  if (resumeNode)
+    setResumeNode(state, resumeNode->getChild(choice));
+}
+
+static void writeForkChoices(llvm::raw_ostream &os,
+                             const std::vector<unsigned> &choices) {
+  for (unsigned i = 0; i != choices.size(); ++i) {
+    if (i)
+      os << ",";
+    os << choices[i];
+  }
+  os << "\n";
+}
+
+unsigned Executor::writeResumePaths(llvm::raw_ostream &os, ResumeNode *node,
+                                    std::vector<unsigned> &path) {
+  if (node->end) {
+    writeForkChoices(os, path);
+    return 1;
+  }
+  unsigned count = 0;
+  for (std::map<unsigned, ResumeNode*>::iterator it = node->children.begin(),
+         ie = node->children.end(); it != ie; ++it) {
+    path.push_back(it->first);
+    count += writeResumePaths(os, it->second, path);
+    path.pop_back();
+  }
+  return count;
+}
+
+void Executor::checkpoint() {
+  // The checkpoint is taken between two instruction steps, so the states
+  // added during the step are not in the state set yet.
+  std::vector<ExecutionState*> live(states.begin(), states.end());
+  live.insert(live.end(), addedStates.begin(), addedStates.end());
+  std::string paths;
+  llvm::raw_string_ostream pathStream(paths);
+  unsigned numPaths = 0;
+  for (std::vector<ExecutionState*>::iterator it = live.begin(),
+         ie = live.end(); it != ie; ++it) {
+    ExecutionState *es = *it;
+    if (removedStates.count(es))
+      continue;
+
+    std::map<ExecutionState*, ResumeNode*>::iterator rit = resumeMap.find(es);
+    if (rit != resumeMap.end()) {
+      std::vector<unsigned> path(es->forkChoices);
+      numPaths += writeResumePaths(pathStream, rit->second, path);
+    } else {
+      writeForkChoices(pathStream, es->forkChoices);
+      ++numPaths;
+    }
+  }
+  pathStream.flush();
+
+  // The paths and the coverage go to one file, so that renaming it replaces
+  // the previous checkpoint as a whole.
+  llvm::raw_fd_ostream *os =
+    interpreterHandler->openOutputFile("checkpoint.tmp");
+  if (!os)
+    return;
+  *os << numPaths << "\n" << paths;
+  if (statsTracker)
+    statsTracker->writeCovered(*os);
+  delete os;
+
+  std::string file = interpreterHandler->getOutputFilename("checkpoint");
+  rename((file + ".tmp").c_str(), file.c_str());
+}
+
+bool Executor::loadCheckpoint(const std::string &directory,
+                              unsigned &numPaths) {
+  std::ifstream in((directory + "/checkpoint").c_str());
+  std::string line;
+  if (!std::getline(in, line))
+    return false;
+  numPaths = atoi(line.c_str());
+
+  delete resumeTree;
+  resumeTree = new ResumeNode();
+  for (unsigned i = 0; i != numPaths; ++i) {
+    if (!std::getline(in, line))
+      return false;
+    ResumeNode *node = resumeTree;
+    const char *s = line.c_str();
+    while (*s) {
+      char *end;
+      unsigned choice = strtoul(s, &end, 10);
+      if (end == s)
+        return false;
+      ResumeNode *&child = node->children[choice];
+      if (!child)
+        child = new ResumeNode();
+      node = child;
+      s = *end == ',' ? end + 1 : end;
+    }
+    node->end = true;
+  }
+
+  unsigned id;
+  resumeCoverage.clear();
+  while (in >> id)
+    resumeCoverage.push_back(id);
+  return true;
+}
+
+void Executor::dumpCoverage() {
+  if (!StatsTracker::useIndexedStatistics()) {
+    klee_warning("not writing coverage.txt (requires --output-istats)");
+    return;
+  }
+
+  std::set< std::pair<std::string, unsigned> > lines;
+  for (std::vector<KFunction*>::iterator it = kmodule->functions.begin(),
+         ie = kmodule->functions.end(); it != ie; ++it) {
+    KFunction *kf = *it;
+    for (unsigned i = 0; i != kf->numInstructions; ++i) {
+      const InstructionInfo &ii = *kf->instructions[i]->info;
+      if (ii.line &&
+          theStatisticManager->getIndexedValue(stats::coveredInstructions,
+                                               ii.id))
+        lines.insert(std::make_pair(ii.file, ii.line));
+    }
+  }
+
+  llvm::raw_ostream *os = interpreterHandler->openOutputFile("coverage.txt");
+  if (!os)
+    return;
+  for (std::set< std::pair<std::string, unsigned> >::iterator
+         it = lines.begin(), ie = lines.end(); it != ie; ++it)
+    *os << it->first << ":" << it->second << "\n";
+  delete os;
 }
 
 std::string Executor::getAddressInfo(ExecutionState &state, 
@@ -2673,14 +3275,13 @@ std::string Executor::getAddressInfo(ExecutionState &state,
   if (ConstantExpr *CE = dyn_cast<ConstantExpr>(address)) {
     example = CE->getZExtValue();
   } else {
-    ref<ConstantExpr> value;
-    bool success = solver->getValue(state, address, value);
+    ref<ConstantExpr> min, max, value;
+    bool success = solver->getRange(state, address, min, max, value);
     assert(success && "FIXME: Unhandled solver failure");
     (void) success;
     example = value->getZExtValue();
     info << "\texample: " << example << "\n";
-    std::pair< ref<Expr>, ref<Expr> > res = solver->getRange(state, address);
-    info << "\trange: [" << res.first << ", " << res.second <<"]\n";
+    info << "\trange: [" << min << ", " << max <<"]\n";
   }
   
   MemoryObject hack((unsigned) example);    
@@ -2714,6 +3315,124 @@ std::string Executor::getAddressInfo(ExecutionState &state,
   return info.str();
 }
 
+/// Create an input with the given values for the symbolic objects.
+static KTest *createKTest(const std::vector< std::pair<const MemoryObject*,
+                                                      const Array*> >
+                            &symbolics,
+                          const std::vector< std::vector<unsigned char> >
+                            &values) {
+  KTest *b = (KTest*) calloc(1, sizeof(*b));
+  b->version = kTest_getCurrentVersion();
+  b->numObjects = symbolics.size();
+  b->objects = (KTestObject*) calloc(b->numObjects, sizeof(*b->objects));
+  for (unsigned i=0; i<b->numObjects; ++i) {
+    KTestObject *o = &b->objects[i];
+    o->name = strdup(symbolics[i].first->name.c_str());
+    o->numBytes = values[i].size();
+    o->bytes = (unsigned char*) malloc(o->numBytes);
+    std::copy(values[i].begin(), values[i].end(), o->bytes);
+  }
+  return b;
+}
+
+void Executor::runConcolic(ExecutionState &initialState) {
+  // Inputs to run, with the index of the first branch to negate: the
+  // branches before it were already negated by the run that generated the
+  // input (or one of its ancestors).
+  std::deque< std::pair<KTest*, unsigned> > inputs;
+  std::vector<KTest*> generated;
+  if (usingSeeds) {
+    for (std::vector<KTest*>::const_iterator it = usingSeeds->begin(),
+           ie = usingSeeds->end(); it != ie; ++it)
+      inputs.push_back(std::make_pair(*it, 0u));
+  } else {
+    std::vector< std::pair<const MemoryObject*, const Array*> > none;
+    generated.push_back(createKTest(none,
+                                    std::vector< std::vector<unsigned char> >()));
+    inputs.push_back(std::make_pair(generated.back(), 0u));
+  }
+
+  unsigned runs = 0;
+  while (!inputs.empty() && !haltExecution) {
+    KTest *input = inputs.front().first;
+    unsigned bound = inputs.front().second;
+    inputs.pop_front();
+
+    // Every run starts from a copy of the initial state, which is itself
+    // never executed.
+    ExecutionState *es = initialState.branch();
+    initialState.ptreeNode->data = 0;
+    std::pair<PTree::Node*,PTree::Node*> res =
+      processTree->split(initialState.ptreeNode, es, &initialState);
+    es->ptreeNode = res.first;
+    initialState.ptreeNode = res.second;
+    states.insert(es);
+    seedMap[es].push_back(SeedInfo(input));
+    concolicPath.clear();
+    ++runs;
+
+    std::vector< std::pair<const MemoryObject*, const Array*> > symbolics;
+    for (;;) {
+      if (haltExecution) {
+        stepInstruction(*es); // keep stats rolling
+        terminateStateEarly(*es, "Execution halting.");
+      } else {
+        KInstruction *ki = es->pc;
+        stepInstruction(*es);
+        executeInstruction(*es, ki);
+        processTimers(es, MaxInstructionTime);
+        checkMemoryUsage();
+      }
+
+      bool done = removedStates.count(es);
+      if (done)
+        symbolics = es->symbolics;
+      updateStates(es);
+      if (done)
+        break;
+    }
+    assert(states.empty() && "concolic run forked");
+
+    std::vector<const Array*> objects;
+    for (unsigned i=0; i<symbolics.size(); ++i)
+      objects.push_back(symbolics[i].second);
+
+    // Negate each branch in turn: the input for branch i follows the path
+    // up to it, then takes the other side.
+    ConstraintManager prefix;
+    for (unsigned i=0; i<concolicPath.size() && !haltExecution; ++i) {
+      if (i >= bound) {
+        TimerStatIncrementer timer(stats::solverTime);
+        std::vector< std::vector<unsigned char> > values;
+        double queryStart = util::getWallTime();
+        solver->setTimeout(
+          solverTimeouts.getTimeout(SolverTimeouts::TestGeneration));
+        bool success = solver->solver->getInitialValues(
+          Query(prefix, concolicPath[i]), objects, values);
+        solver->setTimeout(0);
+        solverTimeouts.recordQuery(SolverTimeouts::TestGeneration,
+                                   util::getWallTime() - queryStart,
+                                   !success && solver->hasTimedOut());
+        if (success) {
+          generated.push_back(createKTest(symbolics, values));
+          inputs.push_back(std::make_pair(generated.back(), i + 1));
+        }
+      }
+      prefix.addConstraint(concolicPath[i]);
+    }
+  }
+
+  klee_message("concolic: %u runs, %u inputs left", runs,
+               (unsigned) inputs.size());
+
+  concolicPath.clear();
+  processTree->remove(initialState.ptreeNode);
+  delete &initialState;
+  for (std::vector<KTest*>::iterator it = generated.begin(),
+         ie = generated.end(); it != ie; ++it)
+    kTest_free(*it);
+}
+
 void Executor::terminateState(ExecutionState &state) {
   if (replayKTest && replayPosition!=replayKTest->numObjects) {
     klee_warning_once(replayKTest,
@@ -2722,8 +3441,7 @@ void Executor::terminateState(ExecutionState &state) {
 
   interpreterHandler->incPathsExplored();
 
-  std::set<ExecutionState*>::iterator it = addedStates.find(&state);
-  if (it==addedStates.end()) {
+  if (!addedStates.count(&state)) {
     state.pc = state.prevPC;
 
     removedStates.insert(&state);
@@ -2733,7 +3451,8 @@ void Executor::terminateState(ExecutionState &state) {
       seedMap.find(&state);
     if (it3 != seedMap.end())
       seedMap.erase(it3);
-    addedStates.erase(it);
+    resumeMap.erase(&state);
+    addedStates.erase(&state);
     processTree->remove(state.ptreeNode);
     delete &state;
   }
@@ -3173,7 +3892,7 @@ void Executor::executeMemoryOperation(ExecutionState &state,
   // fast path: single in-bounds resolution
   ObjectPair op;
   bool success;
-  solver->setTimeout(coreSolverTimeout);
+  solver->setTimeout(solverTimeouts.getTimeout(SolverTimeouts::BoundsCheck));
   if (!state.addressSpace.resolveOne(state, solver, address, op, success)) {
     address = toConstant(state, address, "resolveOne failure");
     success = state.addressSpace.resolveOne(cast<ConstantExpr>(address), op);
@@ -3190,11 +3909,15 @@ void Executor::executeMemoryOperation(ExecutionState &state,
     ref<Expr> offset = mo->getOffsetExpr(address);
 
     bool inBounds;
-    solver->setTimeout(coreSolverTimeout);
+    double queryStart = util::getWallTime();
+    solver->setTimeout(solverTimeouts.getTimeout(SolverTimeouts::BoundsCheck));
     bool success = solver->mustBeTrue(state, 
                                       mo->getBoundsCheckOffset(offset, bytes),
                                       inBounds);
     solver->setTimeout(0);
+    solverTimeouts.recordQuery(SolverTimeouts::BoundsCheck,
+                               util::getWallTime() - queryStart,
+                               !success && solver->hasTimedOut());
     if (!success) {
       state.pc = state.prevPC;
       terminateStateEarly(state, "Query timed out (bounds check).");
@@ -3229,9 +3952,10 @@ void Executor::executeMemoryOperation(ExecutionState &state,
   // resolution with out of bounds)
   
   ResolutionList rl;  
-  solver->setTimeout(coreSolverTimeout);
+  double resolveTimeout = solverTimeouts.getTimeout(SolverTimeouts::BoundsCheck);
+  solver->setTimeout(resolveTimeout);
   bool incomplete = state.addressSpace.resolve(state, solver, address, rl,
-                                               0, coreSolverTimeout);
+                                               0, resolveTimeout);
   solver->setTimeout(0);
   
   // XXX there is some query wasteage here. who cares?
@@ -3306,7 +4030,7 @@ void Executor::executeMakeSymbolic(ExecutionState &state,
         KTestObject *obj = si.getNextInput(mo, NamedSeedMatching);
 
         if (!obj) {
-          if (ZeroSeedExtension) {
+          if (ZeroSeedExtension || Concolic) {
             std::vector<unsigned char> &values = si.assignment.bindings[array];
             values = std::vector<unsigned char>(mo->size, '\0');
           } else if (!AllowSeedExtension) {
@@ -3317,7 +4041,7 @@ void Executor::executeMakeSymbolic(ExecutionState &state,
           }
         } else {
           if (obj->numBytes != mo->size &&
-              ((!(AllowSeedExtension || ZeroSeedExtension)
+              ((!(AllowSeedExtension || ZeroSeedExtension || Concolic)
                 && obj->numBytes < mo->size) ||
                (!AllowSeedTruncation && obj->numBytes > mo->size))) {
 	    std::stringstream msg;
@@ -3334,7 +4058,7 @@ void Executor::executeMakeSymbolic(ExecutionState &state,
             std::vector<unsigned char> &values = si.assignment.bindings[array];
             values.insert(values.begin(), obj->bytes, 
                           obj->bytes + std::min(obj->numBytes, mo->size));
-            if (ZeroSeedExtension) {
+            if (ZeroSeedExtension || Concolic) {
               for (unsigned i=obj->numBytes; i<mo->size; ++i)
                 values.push_back('\0');
             }
@@ -3403,12 +4127,28 @@ void Executor::runFunctionAsMain(Function *f,
     }
   }
 
+  if (!statsTracker && StatsTracker::useStatistics())
+    statsTracker = new StatsTracker(*this, assemblyFilename,
+                                    userSearcherRequiresMD2U());
+  // Like the statistics, these follow the options of a fork server job.
+  if (!subsumptionChecker && UseStateSubsumption)
+    subsumptionChecker = new SubsumptionChecker(kmodule,
+                                                MaxSubsumptionSnapshots);
+  if (!stateMerger && AutoMerge)
+    stateMerger = new StateMerger(AutoMergeMaxRegionSize, AutoMergeMaxCost);
+
   ExecutionState *state = new ExecutionState(kmodule->functionMap[f]);
   
   if (pathWriter) 
     state->pathOS = pathWriter->open();
   if (symPathWriter) 
     state->symPathOS = symPathWriter->open();
+  if (resumeTree)
+    setResumeNode(*state, resumeTree);
+  if (statsTracker && !resumeCoverage.empty()) {
+    statsTracker->markCovered(resumeCoverage);
+    resumeCoverage.clear();
+  }
 
 
   if (statsTracker)
@@ -3510,7 +4250,8 @@ bool Executor::getSymbolicSolution(const ExecutionState &state,
                                    std::pair<std::string,
                                    std::vector<unsigned char> > >
                                    &res) {
-  solver->setTimeout(coreSolverTimeout);
+  double queryStart = util::getWallTime();
+  solver->setTimeout(solverTimeouts.getTimeout(SolverTimeouts::TestGeneration));
 
   ExecutionState tmp(state);
 
@@ -3548,6 +4289,9 @@ bool Executor::getSymbolicSolution(const ExecutionState &state,
     objects.push_back(state.symbolics[i].second);
   bool success = solver->getInitialValues(tmp, objects, values);
   solver->setTimeout(0);
+  solverTimeouts.recordQuery(SolverTimeouts::TestGeneration,
+                             util::getWallTime() - queryStart,
+                             !success && solver->hasTimedOut());
   if (!success) {
     klee_warning("unable to compute initial values (invalid constraints?)!");
     ExprPPrinter::printQuery(llvm::errs(), state.constraints,
@@ -23,6 +23,9 @@
 #include "klee/util/ArrayCache.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include "SolverTimeouts.h"
+#include "StateSet.h"
+
 #include "llvm/ADT/Twine.h"
 
 #include <vector>
@@ -69,9 +72,12 @@ namespace klee {
   class SeedInfo;
   class SpecialFunctionHandler;
   struct StackFrame;
+  class StateMerger;
   class StatsTracker;
+  class SubsumptionChecker;
   class TimingSolver;
   class TreeStreamWriter;
+  class WorkQueue;
   template<class T> class ref;
 
 
@@ -84,6 +90,7 @@ class Executor : public Interpreter {
   friend class BumpMergingSearcher;
   friend class MergingSearcher;
   friend class RandomPathSearcher;
+  friend class TargetedSearcher;
   friend class OwningSearcher;
   friend class WeightedRandomSearcher;
   friend class SpecialFunctionHandler;
@@ -111,23 +118,32 @@ private:
   ExternalDispatcher *externalDispatcher;
   TimingSolver *solver;
   MemoryManager *memory;
-  std::set<ExecutionState*> states;
+  StateSet states;
   StatsTracker *statsTracker;
   TreeStreamWriter *pathWriter, *symPathWriter;
   SpecialFunctionHandler *specialFunctionHandler;
   std::vector<TimerInfo*> timers;
   PTree *processTree;
+  /// When non-null, the states reaching a loop header are checked for
+  /// subsumption by an earlier state. \see isSubsumed()
+  SubsumptionChecker *subsumptionChecker;
+  /// When non-null, the states forked at small branch regions are merged
+  /// at the end of the region. \see mergeBranches()
+  StateMerger *stateMerger;
 
   /// Used to track states that have been added during the current
   /// instructions step. 
   /// \invariant \ref addedStates is a subset of \ref states. 
   /// \invariant \ref addedStates and \ref removedStates are disjoint.
-  std::set<ExecutionState*> addedStates;
+  StateSet addedStates;
   /// Used to track states that have been removed during the current
   /// instructions step. 
   /// \invariant \ref removedStates is a subset of \ref states. 
   /// \invariant \ref addedStates and \ref removedStates are disjoint.
-  std::set<ExecutionState*> removedStates;
+  StateSet removedStates;
+  /// The removed states being deleted by updateStates(), kept as a member
+  /// so that its storage is reused.
+  std::vector<ExecutionState*> statesToDelete;
 
   /// When non-empty the Executor is running in "seed" mode. The
   /// states in this map will be executed in an arbitrary order
@@ -137,6 +153,42 @@ private:
   /// happens with other states (that don't satisfy the seeds) depends
   /// on as-yet-to-be-determined flags.
   std::map<ExecutionState*, std::vector<SeedInfo> > seedMap;
+
+  /// ResumeNode - A node of the tree of the fork choices saved in a
+  /// checkpoint (see ExecutionState::forkChoices). At a fork, only the
+  /// choices with a child are taken; a node ending a path is where
+  /// exploration resumes.
+  struct ResumeNode {
+    std::map<unsigned, ResumeNode*> children;
+    bool end;
+
+    ResumeNode() : end(false) {}
+    ~ResumeNode() {
+      for (std::map<unsigned, ResumeNode*>::iterator it = children.begin(),
+             ie = children.end(); it != ie; ++it)
+        delete it->second;
+    }
+
+    ResumeNode *getChild(unsigned choice) const {
+      std::map<unsigned, ResumeNode*>::const_iterator it =
+        children.find(choice);
+      return it == children.end() ? 0 : it->second;
+    }
+  };
+
+  /// The paths to resume, when resuming from a checkpoint.
+  ResumeNode *resumeTree;
+
+  /// The states still following the paths to resume, with their position
+  /// in the tree. \see loadCheckpoint()
+  std::map<ExecutionState*, ResumeNode*> resumeMap;
+
+  /// The ids of the instructions covered before the checkpoint.
+  std::vector<unsigned> resumeCoverage;
+
+  /// In concolic mode, the branch conditions taken by the current run, in
+  /// order. \see runConcolic()
+  std::vector< ref<Expr> > concolicPath;
   
   /// Map of globals to their representative memory object.
   std::map<const llvm::GlobalValue*, MemoryObject*> globalObjects;
@@ -162,6 +214,13 @@ private:
   /// drive execution.
   const std::vector<struct KTest *> *usingSeeds;  
 
+  /// When non-null the queue through which states are handed over to
+  /// other processes. \see shareWork()
+  WorkQueue *workQueue;
+
+  /// The wall time at which the work queue is next checked.
+  double nextShareTime;
+
   /// Disables forking, instead a random path is chosen. Enabled as
   /// needed to control memory usage. \see fork()
   bool atMemoryLimit;
@@ -181,12 +240,19 @@ private:
   /// (e.g. for a single STP query)
   double coreSolverTimeout;
 
+  /// The timeouts for each class of solver queries, defaulting to
+  /// coreSolverTimeout.
+  SolverTimeouts solverTimeouts;
+
   /// Assumes ownership of the created array objects
   ArrayCache arrayCache;
 
   /// File to print executed instructions to
   llvm::raw_ostream *debugInstFile;
 
+  /// The assembly file of the module, referenced by the statistics.
+  std::string assemblyFilename;
+
   // @brief Buffer used by logBuffer
   std::string debugBufferString;
 
@@ -203,6 +269,12 @@ private:
 
   void run(ExecutionState &initialState);
 
+  /// Run the program once per input, starting from the seeds. Each run
+  /// follows its input without forking, recording the conditions of the
+  /// symbolic branches; new inputs are then generated by negating each of
+  /// them in turn (generational search).
+  void runConcolic(ExecutionState &initialState);
+
   // Given a concrete object in our [klee's] address space, add it to 
   // objects checked code can reference.
   MemoryObject *addExternalObject(ExecutionState &state, void *addr, 
@@ -219,6 +291,57 @@ private:
 			    llvm::BasicBlock *src,
 			    ExecutionState &state);
 
+  /// Attribute forks of the state at its current instruction to the
+  /// innermost loop containing it, if any.
+  void countLoopForks(ExecutionState &state, unsigned forks);
+
+  /// Write the number of forks within each loop to loop-forks.txt.
+  void dumpLoopForks();
+
+  /// Create the solver chain, logging queries to the output directory, and
+  /// set the solver timeouts from the options.
+  void createSolver();
+
+  /// Open the instruction trace in the output directory, if requested.
+  void openDebugInstFile();
+
+  /// Hand over a state other than the current one to the work queue, if
+  /// the queue runs low on jobs.
+  void shareWork(ExecutionState &current);
+
+  /// Write the source lines covered so far to coverage.txt.
+  void dumpCoverage();
+
+  /// Set the position of a resumed state in the tree of paths to resume,
+  /// or let it explore freely past their end.
+  void setResumeNode(ExecutionState &state, ResumeNode *node);
+
+  /// Write the paths to resume below a node, whose path is given, and
+  /// return their number.
+  unsigned writeResumePaths(llvm::raw_ostream &os, ResumeNode *node,
+                            std::vector<unsigned> &path);
+
+  /// Record the choice made by a state at a fork, and follow it in the
+  /// paths to resume.
+  void recordForkChoice(ExecutionState &state, ResumeNode *resumeNode,
+                        unsigned choice);
+
+  /// Report how many of the seeds are done, on the console and in
+  /// seeding.txt.
+  void reportSeedingProgress(unsigned numSeeds, unsigned numStates,
+                             double elapsed);
+
+  /// Return true if the state is about to execute a loop header and is
+  /// subsumed by a snapshot of an earlier state; otherwise record a
+  /// snapshot of it.
+  bool isSubsumed(ExecutionState &state, KInstruction *ki);
+
+  /// Drive the two states forked at the branch terminating bb through the
+  /// region up to its post-dominator, if it is mergeable, and merge the
+  /// resulting states there. This is all done within the current step.
+  void mergeBranches(llvm::BasicBlock *bb, ExecutionState &a,
+                     ExecutionState &b);
+
   void callExternalFunction(ExecutionState &state,
                             KInstruction *target,
                             llvm::Function *function,
@@ -424,6 +547,8 @@ public:
   // XXX should just be moved out to utility module
   ref<klee::ConstantExpr> evalConstant(const llvm::Constant *c);
 
+  virtual void setInterpreterHandler(InterpreterHandler *ih);
+
   virtual void setPathWriter(TreeStreamWriter *tsw) {
     pathWriter = tsw;
   }
@@ -443,6 +568,11 @@ public:
     replayPosition = 0;
   }
 
+  virtual void setWorkQueue(WorkQueue *queue) {
+    assert((!queue || pathWriter) && "work queue requires a path writer");
+    workQueue = queue;
+  }
+
   virtual const llvm::Module *
   setModule(llvm::Module *module, const ModuleOptions &opts);
 
@@ -461,6 +591,13 @@ public:
     haltExecution = value;
   }
 
+  /// Save the fork choices of the live states and the coverage so far to
+  /// the checkpoint file, replacing the previous checkpoint.
+  void checkpoint();
+
+  virtual bool loadCheckpoint(const std::string &directory,
+                              unsigned &numPaths);
+
   virtual void setInhibitForking(bool value) {
     inhibitForking = value;
   }
@@ -42,6 +42,11 @@ MaxTime("max-time",
         cl::desc("Halt execution after the specified number of seconds (default=0 (off))"),
         cl::init(0));
 
+cl::opt<double>
+CheckpointInterval("checkpoint-interval",
+                   cl::desc("Save the states left to explore to the output directory every the specified number of seconds, and when halted. Each checkpoint rewrites the whole path of every state (default=0 (off))"),
+                   cl::init(0));
+
 ///
 
 class HaltTimer : public Executor::Timer {
@@ -59,6 +64,20 @@ public:
 
 ///
 
+class CheckpointTimer : public Executor::Timer {
+  Executor *executor;
+
+public:
+  CheckpointTimer(Executor *_executor) : executor(_executor) {}
+  ~CheckpointTimer() {}
+
+  void run() {
+    executor->checkpoint();
+  }
+};
+
+///
+
 static const double kSecondsPerTick = .1;
 static volatile unsigned timerTicks = 0;
 
@@ -90,6 +109,9 @@ void Executor::initTimers() {
   if (first) {
     first = false;
     setupHandler();
+
+    if (CheckpointInterval)
+      addTimer(new CheckpointTimer(this), CheckpointInterval.getValue());
   }
 
   if (MaxTime) {
@@ -134,7 +156,7 @@ void Executor::processTimers(ExecutionState *current,
       llvm::raw_ostream *os = interpreterHandler->openOutputFile("states.txt");
       
       if (os) {
-        for (std::set<ExecutionState*>::const_iterator it = states.begin(), 
+        for (StateSet::const_iterator it = states.begin(), 
                ie = states.end(); it != ie; ++it) {
           ExecutionState *es = *it;
           *os << "(" << es << ",";
@@ -107,6 +107,7 @@ ObjectState::ObjectState(const MemoryObject *mo)
     flushMask(0),
     knownSymbolics(0),
     updates(0, 0),
+    contentHashValid(false),
     size(mo->size),
     readOnly(false) {
   mo->refCount++;
@@ -129,6 +130,7 @@ ObjectState::ObjectState(const MemoryObject *mo, const Array *array)
     flushMask(0),
     knownSymbolics(0),
     updates(array, 0),
+    contentHashValid(false),
     size(mo->size),
     readOnly(false) {
   mo->refCount++;
@@ -145,6 +147,8 @@ ObjectState::ObjectState(const ObjectState &os)
     flushMask(os.flushMask ? new BitArray(*os.flushMask, os.size) : 0),
     knownSymbolics(0),
     updates(os.updates),
+    contentHash(os.contentHash),
+    contentHashValid(os.contentHashValid),
     size(os.size),
     readOnly(false) {
   assert(!os.readOnly && "no need to copy read only object?");
@@ -235,7 +239,13 @@ const UpdateList &ObjectState::getUpdates() const {
   return updates;
 }
 
+void ObjectState::writeConcreteStore(const uint8_t *data) {
+  contentHashValid = false;
+  memcpy(concreteStore, data, size);
+}
+
 void ObjectState::makeConcrete() {
+  contentHashValid = false;
   if (concreteMask) delete concreteMask;
   if (flushMask) delete flushMask;
   if (knownSymbolics) delete[] knownSymbolics;
@@ -247,6 +257,7 @@ void ObjectState::makeConcrete() {
 void ObjectState::makeSymbolic() {
   assert(!updates.head &&
          "XXX makeSymbolic of objects with symbolic values is unsupported");
+  contentHashValid = false;
 
   // XXX simplify this, can just delete various arrays I guess
   for (unsigned i=0; i<size; i++) {
@@ -258,11 +269,13 @@ void ObjectState::makeSymbolic() {
 
 void ObjectState::initializeToZero() {
   makeConcrete();
+  contentHashValid = false;
   memset(concreteStore, 0, size);
 }
 
 void ObjectState::initializeToRandom() {  
   makeConcrete();
+  contentHashValid = false;
   for (unsigned i=0; i<size; i++) {
     // randomly selected by 256 sided die
     concreteStore[i] = 0xAB;
@@ -416,6 +429,7 @@ ref<Expr> ObjectState::read8(ref<Expr> offset) const {
 
 void ObjectState::write8(unsigned offset, uint8_t value) {
   //assert(read_only == false && "writing to read-only object!");
+  contentHashValid = false;
   concreteStore[offset] = value;
   setKnownSymbolic(offset, 0);
 
@@ -428,6 +442,7 @@ void ObjectState::write8(unsigned offset, ref<Expr> value) {
   if (ConstantExpr *CE = dyn_cast<ConstantExpr>(value)) {
     write8(offset, (uint8_t) CE->getZExtValue(8));
   } else {
+    contentHashValid = false;
     setKnownSymbolic(offset, value.get());
       
     markByteSymbolic(offset);
@@ -437,6 +452,7 @@ void ObjectState::write8(unsigned offset, ref<Expr> value) {
 
 void ObjectState::write8(ref<Expr> offset, ref<Expr> value) {
   assert(!isa<ConstantExpr>(offset) && "constant offset passed to symbolic write8");
+  contentHashValid = false;
   unsigned base, size;
   fastRangeCheckOffset(offset, &base, &size);
   flushRangeForWrite(base, size);
@@ -452,6 +468,33 @@ void ObjectState::write8(ref<Expr> offset, ref<Expr> value) {
   updates.extend(ZExtExpr::create(offset, Expr::Int32), value);
 }
 
+unsigned ObjectState::getContentHash() const {
+  if (contentHashValid)
+    return contentHash;
+
+  // Bytes only known through the update list (symbolic contents, or
+  // contents flushed by a symbolic write) are accounted for by hashing the
+  // list. Constant arrays are created lazily, so their roots are ignored.
+  unsigned res = size;
+  if (updates.root && updates.root->isSymbolicArray())
+    res = res * Expr::MAGIC_HASH_CONSTANT + updates.root->hash();
+  if (updates.head)
+    res = res * Expr::MAGIC_HASH_CONSTANT + updates.head->hash();
+
+  for (unsigned i = 0; i != size; ++i) {
+    unsigned byte = 0;
+    if (isByteConcrete(i))
+      byte = concreteStore[i] + 1;
+    else if (isByteKnownSymbolic(i))
+      byte = knownSymbolics[i]->hash();
+    res = res * Expr::MAGIC_HASH_CONSTANT + byte;
+  }
+
+  contentHash = res;
+  contentHashValid = true;
+  return res;
+}
+
 /***/
 
 ref<Expr> ObjectState::read(ref<Expr> offset, Expr::Width width) const {
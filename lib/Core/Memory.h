@@ -168,6 +168,10 @@ private:
   // mutable because we may need flush during read of const
   mutable UpdateList updates;
 
+  /// Hash of the contents, valid until the object is next written.
+  mutable unsigned contentHash;
+  mutable bool contentHashValid;
+
 public:
   unsigned size;
 
@@ -208,9 +212,18 @@ public:
   void write32(unsigned offset, uint32_t value);
   void write64(unsigned offset, uint64_t value);
 
+  /// getContentHash - Return a hash of the contents of the object, such
+  /// that objects with the same contents have the same hash. The hash is
+  /// cached until the object is next written.
+  unsigned getContentHash() const;
+
 private:
   const UpdateList &getUpdates() const;
 
+  /// Overwrite the concrete store with the given bytes, as copied in from
+  /// the memory of the program (see AddressSpace::copyInConcretes).
+  void writeConcreteStore(const uint8_t *data);
+
   void makeConcrete();
 
   void makeSymbolic();
@@ -12,24 +12,55 @@
 #include <klee/Expr.h>
 #include <klee/util/ExprPPrinter.h>
 
+#include <new>
 #include <vector>
 
 using namespace klee;
 
   /* *** */
 
-PTree::PTree(const data_type &_root) : root(new Node(0,_root)) {
+PTree::PTree(const data_type &_root)
+  : freeList(0), chunkUsed(ChunkSize) {
+  root = allocate(0, _root);
 }
 
-PTree::~PTree() {}
+PTree::~PTree() {
+  for (std::vector<void*>::iterator it = chunks.begin(), ie = chunks.end();
+       it != ie; ++it)
+    ::operator delete(*it);
+}
+
+PTreeNode *PTree::allocate(Node *parent, const data_type &data) {
+  void *mem;
+  if (freeList) {
+    mem = freeList;
+    freeList = *reinterpret_cast<Node**>(freeList);
+  } else {
+    if (chunkUsed == ChunkSize) {
+      chunks.push_back(::operator new(ChunkSize * sizeof(Node)));
+      chunkUsed = 0;
+    }
+    mem = static_cast<Node*>(chunks.back()) + chunkUsed++;
+  }
+  return new (mem) Node(parent, data);
+}
+
+void PTree::release(Node *n) {
+  n->~PTreeNode();
+  *reinterpret_cast<Node**>(n) = freeList;
+  freeList = n;
+}
 
 std::pair<PTreeNode*, PTreeNode*>
 PTree::split(Node *n, 
              const data_type &leftData, 
              const data_type &rightData) {
   assert(n && !n->left && !n->right);
-  n->left = new Node(n, leftData);
-  n->right = new Node(n, rightData);
+  n->left = allocate(n, leftData);
+  n->right = allocate(n, rightData);
+  // A leaf with one state becomes a node with two.
+  for (Node *p = n; p; p = p->parent)
+    ++p->numStates;
   return std::make_pair(n->left, n->right);
 }
 
@@ -37,7 +68,6 @@ void PTree::remove(Node *n) {
   assert(!n->left && !n->right);
   do {
     Node *p = n->parent;
-    delete n;
     if (p) {
       if (n == p->left) {
         p->left = 0;
@@ -46,8 +76,12 @@ void PTree::remove(Node *n) {
         p->right = 0;
       }
     }
+    release(n);
     n = p;
   } while (n && !n->left && !n->right);
+
+  for (; n; n = n->parent)
+    --n->numStates;
 }
 
 void PTree::dump(llvm::raw_ostream &os) {
@@ -94,7 +128,8 @@ PTreeNode::PTreeNode(PTreeNode *_parent,
     left(0),
     right(0),
     data(_data),
-    condition(0) {
+    condition(0),
+    numStates(1) {
 }
 
 PTreeNode::~PTreeNode() {
@@ -12,6 +12,8 @@
 
 #include <klee/Expr.h>
 
+#include <vector>
+
 namespace klee {
   class ExecutionState;
 
@@ -22,6 +24,20 @@ namespace klee {
     typedef class PTreeNode Node;
     Node *root;
 
+  private:
+    /// Nodes are allocated in chunks of this many nodes, so that nodes
+    /// created together (and typically walked together) are close in
+    /// memory, and removed nodes are recycled through a free list.
+    enum { ChunkSize = 256 };
+
+    std::vector<void*> chunks;
+    Node *freeList;
+    unsigned chunkUsed;
+
+    Node *allocate(Node *parent, const data_type &data);
+    void release(Node *n);
+
+  public:
     PTree(const data_type &_root);
     ~PTree();
     
@@ -39,6 +55,9 @@ namespace klee {
     PTreeNode *parent, *left, *right;
     ExecutionState *data;
     ref<Expr> condition;
+    /// The number of states (leaves) in the subtree rooted at this node,
+    /// maintained by PTree::split and PTree::remove.
+    unsigned numStates;
 
   private:
     PTreeNode(PTreeNode *_parent, ExecutionState *_data);
@@ -26,10 +26,12 @@
 #include "klee/Internal/Support/ErrorHandling.h"
 #if LLVM_VERSION_CODE >= LLVM_VERSION(3, 3)
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
 #else
 #include "llvm/Constants.h"
+#include "llvm/InlineAsm.h"
 #include "llvm/Instructions.h"
 #include "llvm/Module.h"
 #endif
@@ -41,9 +43,12 @@
 #include "llvm/IR/CallSite.h"
 #endif
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <fstream>
 #include <climits>
+#include <cmath>
 
 using namespace klee;
 using namespace llvm;
@@ -67,12 +72,12 @@ ExecutionState &DFSSearcher::selectState() {
 }
 
 void DFSSearcher::update(ExecutionState *current,
-                         const std::set<ExecutionState*> &addedStates,
-                         const std::set<ExecutionState*> &removedStates) {
+                         const std::vector<ExecutionState*> &addedStates,
+                         const std::vector<ExecutionState*> &removedStates) {
   states.insert(states.end(),
                 addedStates.begin(),
                 addedStates.end());
-  for (std::set<ExecutionState*>::const_iterator it = removedStates.begin(),
+  for (std::vector<ExecutionState*>::const_iterator it = removedStates.begin(),
          ie = removedStates.end(); it != ie; ++it) {
     ExecutionState *es = *it;
     if (es == states.back()) {
@@ -101,12 +106,12 @@ ExecutionState &BFSSearcher::selectState() {
 }
 
 void BFSSearcher::update(ExecutionState *current,
-                         const std::set<ExecutionState*> &addedStates,
-                         const std::set<ExecutionState*> &removedStates) {
+                         const std::vector<ExecutionState*> &addedStates,
+                         const std::vector<ExecutionState*> &removedStates) {
   states.insert(states.end(),
                 addedStates.begin(),
                 addedStates.end());
-  for (std::set<ExecutionState*>::const_iterator it = removedStates.begin(),
+  for (std::vector<ExecutionState*>::const_iterator it = removedStates.begin(),
          ie = removedStates.end(); it != ie; ++it) {
     ExecutionState *es = *it;
     if (es == states.front()) {
@@ -131,30 +136,18 @@ void BFSSearcher::update(ExecutionState *current,
 ///
 
 ExecutionState &RandomSearcher::selectState() {
-  return *states[theRNG.getInt32()%states.size()];
+  return *states.getStates()[theRNG.getInt32()%states.size()];
 }
 
 void RandomSearcher::update(ExecutionState *current,
-                            const std::set<ExecutionState*> &addedStates,
-                            const std::set<ExecutionState*> &removedStates) {
-  states.insert(states.end(),
-                addedStates.begin(),
-                addedStates.end());
-  for (std::set<ExecutionState*>::const_iterator it = removedStates.begin(),
+                            const std::vector<ExecutionState*> &addedStates,
+                            const std::vector<ExecutionState*> &removedStates) {
+  states.insert(addedStates.begin(), addedStates.end());
+  for (std::vector<ExecutionState*>::const_iterator it = removedStates.begin(),
          ie = removedStates.end(); it != ie; ++it) {
-    ExecutionState *es = *it;
-    bool ok = false;
-
-    for (std::vector<ExecutionState*>::iterator it = states.begin(),
-           ie = states.end(); it != ie; ++it) {
-      if (es==*it) {
-        states.erase(it);
-        ok = true;
-        break;
-      }
-    }
-    
+    bool ok = states.erase(*it);
     assert(ok && "invalid state removed");
+    (void) ok;
   }
 }
 
@@ -162,7 +155,8 @@ void RandomSearcher::update(ExecutionState *current,
 
 WeightedRandomSearcher::WeightedRandomSearcher(WeightType _type)
   : states(new DiscretePDF<ExecutionState*>()),
-    type(_type) {
+    type(_type),
+    lastCoverageEpoch(0) {
   switch(type) {
   case Depth: 
     updateWeights = false;
@@ -184,9 +178,32 @@ WeightedRandomSearcher::~WeightedRandomSearcher() {
 }
 
 ExecutionState &WeightedRandomSearcher::selectState() {
+  refreshWeights();
   return *states->choose(theRNG.getDoubleL());
 }
 
+/// Recompute the weights of the states whose weight inputs changed since the
+/// last selection. This is done in bulk when a state is selected rather than
+/// on every update, so a state running for many instructions (e.g. under the
+/// batching searcher) is only reweighted once.
+void WeightedRandomSearcher::refreshWeights() {
+  if (type == MinDistToUncovered || type == CoveringNew) {
+    uint64_t epoch = getCoverageEpoch();
+    if (epoch != lastCoverageEpoch) {
+      for (StateSet::const_iterator it = members.begin(), ie = members.end();
+           it != ie; ++it)
+        if ((*it)->coverageEpoch > lastCoverageEpoch)
+          dirtyStates.insert(*it);
+      lastCoverageEpoch = epoch;
+    }
+  }
+
+  for (StateSet::const_iterator it = dirtyStates.begin(),
+         ie = dirtyStates.end(); it != ie; ++it)
+    states->update(*it, getWeight(*it));
+  dirtyStates.clear();
+}
+
 double WeightedRandomSearcher::getWeight(ExecutionState *es) {
   switch(type) {
   default:
@@ -225,20 +242,25 @@ double WeightedRandomSearcher::getWeight(ExecutionState *es) {
 }
 
 void WeightedRandomSearcher::update(ExecutionState *current,
-                                    const std::set<ExecutionState*> &addedStates,
-                                    const std::set<ExecutionState*> &removedStates) {
-  if (current && updateWeights && !removedStates.count(current))
-    states->update(current, getWeight(current));
+                                    const std::vector<ExecutionState*> &addedStates,
+                                    const std::vector<ExecutionState*> &removedStates) {
+  // The weight of the current state is only recomputed on the next
+  // selection (see refreshWeights).
+  if (current && updateWeights && members.count(current))
+    dirtyStates.insert(current);
   
-  for (std::set<ExecutionState*>::const_iterator it = addedStates.begin(),
+  for (std::vector<ExecutionState*>::const_iterator it = addedStates.begin(),
          ie = addedStates.end(); it != ie; ++it) {
     ExecutionState *es = *it;
     states->insert(es, getWeight(es));
+    members.insert(es);
   }
 
-  for (std::set<ExecutionState*>::const_iterator it = removedStates.begin(),
+  for (std::vector<ExecutionState*>::const_iterator it = removedStates.begin(),
          ie = removedStates.end(); it != ie; ++it) {
     states->remove(*it);
+    members.erase(*it);
+    dirtyStates.erase(*it);
   }
 }
 
@@ -248,8 +270,8 @@ bool WeightedRandomSearcher::empty() {
 
 ///
 
-RandomPathSearcher::RandomPathSearcher(Executor &_executor)
-  : executor(_executor) {
+RandomPathSearcher::RandomPathSearcher(Executor &_executor, bool _uniform)
+  : executor(_executor), uniform(_uniform) {
 }
 
 RandomPathSearcher::~RandomPathSearcher() {
@@ -264,6 +286,9 @@ ExecutionState &RandomPathSearcher::selectState() {
       n = n->right;
     } else if (!n->right) {
       n = n->left;
+    } else if (uniform) {
+      n = theRNG.getInt32() % n->numStates < n->left->numStates ?
+        n->left : n->right;
     } else {
       if (bits==0) {
         flips = theRNG.getInt32();
@@ -278,8 +303,8 @@ ExecutionState &RandomPathSearcher::selectState() {
 }
 
 void RandomPathSearcher::update(ExecutionState *current,
-                                const std::set<ExecutionState*> &addedStates,
-                                const std::set<ExecutionState*> &removedStates) {
+                                const std::vector<ExecutionState*> &addedStates,
+                                const std::vector<ExecutionState*> &removedStates) {
 }
 
 bool RandomPathSearcher::empty() { 
@@ -288,6 +313,290 @@ bool RandomPathSearcher::empty() {
 
 ///
 
+static bool pathEndsWith(const std::string &path, const std::string &file) {
+  if (path.size() < file.size() ||
+      path.compare(path.size() - file.size(), file.size(), file) != 0)
+    return false;
+  return path.size() == file.size() ||
+    path[path.size() - file.size() - 1] == '/';
+}
+
+bool TargetedSearcher::QueueOrder::operator()(
+    const std::pair<uint64_t, ExecutionState*> &a,
+    const std::pair<uint64_t, ExecutionState*> &b) const {
+  if (a.first != b.first)
+    return a.first < b.first;
+  return a.second->id < b.second->id;
+}
+
+TargetedSearcher::TargetedSearcher(Executor &_executor,
+                                   const std::vector<std::string> &locations)
+  : executor(_executor),
+    numTargets(0) {
+  KModule *km = executor.kmodule;
+  for (std::vector<KFunction*>::iterator it = km->functions.begin(),
+         ie = km->functions.end(); it != ie; ++it) {
+    KFunction *kf = *it;
+    FunctionDistances &fd = distances[kf];
+    fd.toReturn.assign(kf->numInstructions, 0);
+    fd.toTarget.assign(kf->numInstructions, 0);
+    for (unsigned i = 0; i != kf->numInstructions; ++i)
+      if (isa<ReturnInst>(kf->instructions[i]->inst))
+        fd.toReturn[i] = 1;
+  }
+
+  findTargets(locations);
+
+  // Code marked as changed since a previous version (see --patch-base).
+  for (std::vector<KFunction*>::iterator it = km->functions.begin(),
+         ie = km->functions.end(); it != ie; ++it) {
+    KFunction *kf = *it;
+    for (unsigned i = 0; i != kf->numInstructions; ++i) {
+      if (isChangedCode(kf->instructions[i]->inst)) {
+        distances[kf].toTarget[i] = 1;
+        ++numTargets;
+      }
+    }
+  }
+
+  if (!numTargets)
+    klee_error("no target for --search=targeted (see --target-locations "
+               "and --patch-base)");
+
+  computeCallTargets();
+  computeDistances(false);
+  computeDistances(true);
+}
+
+bool TargetedSearcher::hasChangedCode(Executor &executor) {
+  KModule *km = executor.kmodule;
+  for (std::vector<KFunction*>::iterator it = km->functions.begin(),
+         ie = km->functions.end(); it != ie; ++it)
+    for (unsigned i = 0; i != (*it)->numInstructions; ++i)
+      if (isChangedCode((*it)->instructions[i]->inst))
+        return true;
+  return false;
+}
+
+void TargetedSearcher::findTargets(const std::vector<std::string> &locations) {
+  KModule *km = executor.kmodule;
+  for (std::vector<std::string>::const_iterator it = locations.begin(),
+         ie = locations.end(); it != ie; ++it) {
+    std::string::size_type colon = it->rfind(':');
+    unsigned line = 0;
+    if (colon != std::string::npos)
+      line = atoi(it->c_str() + colon + 1);
+    if (!line)
+      klee_error("invalid target location: %s (expected file:line)",
+                 it->c_str());
+    std::string file = it->substr(0, colon);
+
+    unsigned matched = 0;
+    for (std::vector<KFunction*>::iterator fit = km->functions.begin(),
+           fie = km->functions.end(); fit != fie; ++fit) {
+      KFunction *kf = *fit;
+      for (unsigned i = 0; i != kf->numInstructions; ++i) {
+        const InstructionInfo &ii = *kf->instructions[i]->info;
+        if (ii.line == line && pathEndsWith(ii.file, file)) {
+          distances[kf].toTarget[i] = 1;
+          ++matched;
+        }
+      }
+    }
+
+    if (!matched)
+      klee_warning("target location %s does not match any instruction",
+                   it->c_str());
+    numTargets += matched;
+  }
+}
+
+void TargetedSearcher::computeCallTargets() {
+  // Indirect calls are assumed to reach every escaping function, as in
+  // StatsTracker::computeReachableUncovered.
+  KModule *km = executor.kmodule;
+  for (std::vector<KFunction*>::iterator it = km->functions.begin(),
+         ie = km->functions.end(); it != ie; ++it) {
+    KFunction *kf = *it;
+    for (unsigned i = 0; i != kf->numInstructions; ++i) {
+      Instruction *inst = kf->instructions[i]->inst;
+      if (!isa<CallInst>(inst) && !isa<InvokeInst>(inst))
+        continue;
+
+      CallSite cs(inst);
+      if (isa<InlineAsm>(cs.getCalledValue())) {
+        callTargets.insert(std::make_pair(inst, std::vector<Function*>()));
+      } else if (Function *target = getDirectCallTarget(cs)) {
+        callTargets[inst].push_back(target);
+      } else {
+        callTargets[inst] =
+          std::vector<Function*>(km->escapingFunctions.begin(),
+                                 km->escapingFunctions.end());
+      }
+    }
+  }
+}
+
+/// Compute the distance (in instructions) from every instruction to the
+/// closest return, or to the closest target. The distances to return must
+/// be known before the distances to the targets are computed.
+void TargetedSearcher::computeDistances(bool toTarget) {
+  KModule *km = executor.kmodule;
+  bool changed;
+  do {
+    changed = false;
+    for (std::vector<KFunction*>::iterator it = km->functions.begin(),
+           ie = km->functions.end(); it != ie; ++it) {
+      KFunction *kf = *it;
+      FunctionDistances &fd = distances[kf];
+      std::vector<uint64_t> &dist = toTarget ? fd.toTarget : fd.toReturn;
+
+      // Visit the instructions backwards, so most distances propagate in a
+      // single pass.
+      for (unsigned i = kf->numInstructions; i != 0; --i) {
+        Instruction *inst = kf->instructions[i - 1]->inst;
+        uint64_t best, cur = best = dist[i - 1];
+        uint64_t bestThrough = 0;
+
+        if (isa<CallInst>(inst) || isa<InvokeInst>(inst)) {
+          std::vector<Function*> &targets = callTargets[inst];
+          for (std::vector<Function*>::iterator fnIt = targets.begin(),
+                 fnIe = targets.end(); fnIt != fnIe; ++fnIt) {
+            uint64_t through;
+            std::map<llvm::Function*, KFunction*>::iterator kfIt =
+              km->functionMap.find(*fnIt);
+            if (kfIt == km->functionMap.end()) {
+              through = (*fnIt)->doesNotReturn() ? 0 : 1;
+            } else {
+              FunctionDistances &callee = distances[kfIt->second];
+              through = callee.toReturn[0];
+              if (toTarget && callee.toTarget[0]) {
+                uint64_t calleeDist = 1 + callee.toTarget[0];
+                if (best == 0 || calleeDist < best)
+                  best = calleeDist;
+              }
+            }
+
+            if (through) {
+              through = 1 + through; // count instruction itself
+              if (bestThrough == 0 || through < bestThrough)
+                bestThrough = through;
+            }
+          }
+        } else {
+          bestThrough = 1;
+        }
+
+        if (bestThrough) {
+          std::vector<unsigned> succs;
+          if (TerminatorInst *ti = dyn_cast<TerminatorInst>(inst)) {
+            for (unsigned j = 0; j != ti->getNumSuccessors(); ++j)
+              succs.push_back(kf->basicBlockEntry[ti->getSuccessor(j)]);
+          } else {
+            succs.push_back(i);
+          }
+
+          for (std::vector<unsigned>::iterator sit = succs.begin(),
+                 sie = succs.end(); sit != sie; ++sit) {
+            if (uint64_t d = dist[*sit]) {
+              uint64_t val = bestThrough + d;
+              if (best == 0 || val < best)
+                best = val;
+            }
+          }
+        }
+
+        if (best != cur) {
+          dist[i - 1] = best;
+          changed = true;
+        }
+      }
+    }
+  } while (changed);
+}
+
+uint64_t TargetedSearcher::getDistance(const KFunction *kf,
+                                       const KInstruction *ki,
+                                       bool toTarget) {
+  // Instruction ids are allocated in order within a function, like the
+  // instructions of the KFunction.
+  unsigned index = ki->info->id - kf->instructions[0]->info->id;
+  assert(index < kf->numInstructions && "instruction not in function");
+  const FunctionDistances &fd = distances[kf];
+  return toTarget ? fd.toTarget[index] : fd.toReturn[index];
+}
+
+/// Return the context sensitive distance from the state to the closest
+/// target: either in the current frame, or after returning from some
+/// frames (see computeMinDistToUncovered). Zero means unreachable.
+uint64_t TargetedSearcher::getDistance(ExecutionState *es) {
+  uint64_t best = 0, toCaller = 0;
+  KInstruction *ki = es->pc;
+  for (ExecutionState::stack_ty::reverse_iterator it = es->stack.rbegin(),
+         ie = es->stack.rend(); it != ie; ++it) {
+    if (uint64_t local = getDistance(it->kf, ki, true))
+      if (best == 0 || toCaller + local < best)
+        best = toCaller + local;
+
+    uint64_t toReturn = getDistance(it->kf, ki, false);
+    if (!toReturn || !it->caller)
+      break;
+    toCaller += toReturn;
+
+    KInstIterator next = it->caller;
+    ki = ++next;
+  }
+  return best;
+}
+
+void TargetedSearcher::enqueue(ExecutionState *es) {
+  uint64_t distance = getDistance(es);
+  if (!distance)
+    distance = ~(uint64_t) 0;
+  if (es->id >= stateDistances.size())
+    stateDistances.resize(es->id + 1);
+  stateDistances[es->id] = distance;
+  queue.insert(std::make_pair(distance, es));
+}
+
+void TargetedSearcher::dequeue(ExecutionState *es) {
+  bool ok = queue.erase(std::make_pair(stateDistances[es->id], es));
+  assert(ok && "invalid state removed");
+  (void) ok;
+}
+
+ExecutionState &TargetedSearcher::selectState() {
+  // The distance of a state only changes when it executes, so it is only
+  // recomputed for the states which ran since the last selection.
+  for (StateSet::const_iterator it = dirtyStates.begin(),
+         ie = dirtyStates.end(); it != ie; ++it) {
+    dequeue(*it);
+    enqueue(*it);
+  }
+  dirtyStates.clear();
+
+  return *queue.begin()->second;
+}
+
+void TargetedSearcher::update(ExecutionState *current,
+                              const std::vector<ExecutionState*> &addedStates,
+                              const std::vector<ExecutionState*> &removedStates) {
+  if (current)
+    dirtyStates.insert(current);
+
+  for (std::vector<ExecutionState*>::const_iterator it = addedStates.begin(),
+         ie = addedStates.end(); it != ie; ++it)
+    enqueue(*it);
+
+  for (std::vector<ExecutionState*>::const_iterator it = removedStates.begin(),
+         ie = removedStates.end(); it != ie; ++it) {
+    dequeue(*it);
+    dirtyStates.erase(*it);
+  }
+}
+
+///
+
 BumpMergingSearcher::BumpMergingSearcher(Executor &_executor, Searcher *_baseSearcher) 
   : executor(_executor),
     baseSearcher(_baseSearcher),
@@ -359,8 +668,8 @@ entry:
 }
 
 void BumpMergingSearcher::update(ExecutionState *current,
-                                 const std::set<ExecutionState*> &addedStates,
-                                 const std::set<ExecutionState*> &removedStates) {
+                                 const std::vector<ExecutionState*> &addedStates,
+                                 const std::vector<ExecutionState*> &removedStates) {
   baseSearcher->update(current, addedStates, removedStates);
 }
 
@@ -473,18 +782,15 @@ ExecutionState &MergingSearcher::selectState() {
 }
 
 void MergingSearcher::update(ExecutionState *current,
-                             const std::set<ExecutionState*> &addedStates,
-                             const std::set<ExecutionState*> &removedStates) {
+                             const std::vector<ExecutionState*> &addedStates,
+                             const std::vector<ExecutionState*> &removedStates) {
   if (!removedStates.empty()) {
-    std::set<ExecutionState *> alt = removedStates;
-    for (std::set<ExecutionState*>::const_iterator it = removedStates.begin(),
+    alt.clear();
+    for (std::vector<ExecutionState*>::const_iterator it = removedStates.begin(),
            ie = removedStates.end(); it != ie; ++it) {
       ExecutionState *es = *it;
-      std::set<ExecutionState*>::const_iterator it2 = statesAtMerge.find(es);
-      if (it2 != statesAtMerge.end()) {
-        statesAtMerge.erase(it2);
-        alt.erase(alt.find(es));
-      }
+      if (!statesAtMerge.erase(es))
+        alt.push_back(es);
     }    
     baseSearcher->update(current, addedStates, alt);
   } else {
@@ -530,9 +836,10 @@ ExecutionState &BatchingSearcher::selectState() {
 }
 
 void BatchingSearcher::update(ExecutionState *current,
-                              const std::set<ExecutionState*> &addedStates,
-                              const std::set<ExecutionState*> &removedStates) {
-  if (removedStates.count(lastState))
+                              const std::vector<ExecutionState*> &addedStates,
+                              const std::vector<ExecutionState*> &removedStates) {
+  if (std::find(removedStates.begin(), removedStates.end(), lastState) !=
+      removedStates.end())
     lastState = 0;
   baseSearcher->update(current, addedStates, removedStates);
 }
@@ -555,27 +862,27 @@ ExecutionState &IterativeDeepeningTimeSearcher::selectState() {
 }
 
 void IterativeDeepeningTimeSearcher::update(ExecutionState *current,
-                                            const std::set<ExecutionState*> &addedStates,
-                                            const std::set<ExecutionState*> &removedStates) {
+                                            const std::vector<ExecutionState*> &addedStates,
+                                            const std::vector<ExecutionState*> &removedStates) {
   double elapsed = util::getWallTime() - startTime;
 
   if (!removedStates.empty()) {
-    std::set<ExecutionState *> alt = removedStates;
-    for (std::set<ExecutionState*>::const_iterator it = removedStates.begin(),
+    alt.clear();
+    for (std::vector<ExecutionState*>::const_iterator it = removedStates.begin(),
            ie = removedStates.end(); it != ie; ++it) {
       ExecutionState *es = *it;
-      std::set<ExecutionState*>::const_iterator it2 = pausedStates.find(es);
-      if (it2 != pausedStates.end()) {
-        pausedStates.erase(it);
-        alt.erase(alt.find(es));
-      }
+      if (!pausedStates.erase(es))
+        alt.push_back(es);
     }    
     baseSearcher->update(current, addedStates, alt);
   } else {
     baseSearcher->update(current, addedStates, removedStates);
   }
 
-  if (current && !removedStates.count(current) && elapsed>time) {
+  if (current &&
+      std::find(removedStates.begin(), removedStates.end(), current) ==
+        removedStates.end() &&
+      elapsed>time) {
     pausedStates.insert(current);
     baseSearcher->removeState(current);
   }
@@ -583,8 +890,88 @@ void IterativeDeepeningTimeSearcher::update(ExecutionState *current,
   if (baseSearcher->empty()) {
     time *= 2;
     llvm::errs() << "KLEE: increasing time budget to: " << time << "\n";
-    baseSearcher->update(0, pausedStates, std::set<ExecutionState*>());
+    std::vector<ExecutionState*> resumed(pausedStates.begin(),
+                                         pausedStates.end());
     pausedStates.clear();
+    baseSearcher->update(0, resumed, std::vector<ExecutionState*>());
+  }
+}
+
+/***/
+
+LoopBudgetSearcher::LoopBudgetSearcher(Searcher *_baseSearcher,
+                                       unsigned _budget)
+  : baseSearcher(_baseSearcher),
+    budget(_budget) {
+}
+
+LoopBudgetSearcher::~LoopBudgetSearcher() {
+  delete baseSearcher;
+}
+
+bool LoopBudgetSearcher::isOverBudget(ExecutionState *es) const {
+  // Only the loops the state is in count: the iterations of the loops it
+  // left are kept until they are entered again.
+  const StackFrame &sf = es->stack.back();
+  std::map<llvm::BasicBlock*, llvm::BasicBlock*>::const_iterator it =
+    sf.kf->loopHeaders.find(es->pc->inst->getParent());
+  if (it == sf.kf->loopHeaders.end())
+    return false;
+  for (llvm::BasicBlock *header = it->second; header; ) {
+    std::map<llvm::BasicBlock*, unsigned>::const_iterator iit =
+      sf.loopIterations.find(header);
+    if (iit != sf.loopIterations.end() && iit->second > budget)
+      return true;
+    it = sf.kf->outerLoopHeaders.find(header);
+    header = it == sf.kf->outerLoopHeaders.end() ? 0 : it->second;
+  }
+  return false;
+}
+
+ExecutionState &LoopBudgetSearcher::selectState() {
+  // The random path searcher ignores removeState, so it may still pick a
+  // throttled state; retry a few times before giving in.
+  for (unsigned i = 0; i != 8; ++i) {
+    ExecutionState &es = baseSearcher->selectState();
+    if (!throttledStates.count(&es))
+      return es;
+  }
+  return baseSearcher->selectState();
+}
+
+void LoopBudgetSearcher::update(ExecutionState *current,
+                                const std::vector<ExecutionState*> &addedStates,
+                                const std::vector<ExecutionState*> &removedStates) {
+  added.clear();
+  removed.clear();
+  for (std::vector<ExecutionState*>::const_iterator it = addedStates.begin(),
+         ie = addedStates.end(); it != ie; ++it) {
+    if (isOverBudget(*it))
+      throttledStates.insert(*it);
+    else
+      added.push_back(*it);
+  }
+  for (std::vector<ExecutionState*>::const_iterator it = removedStates.begin(),
+         ie = removedStates.end(); it != ie; ++it)
+    if (!throttledStates.erase(*it))
+      removed.push_back(*it);
+  baseSearcher->update(current, added, removed);
+
+  if (current &&
+      std::find(removedStates.begin(), removedStates.end(), current) ==
+        removedStates.end() &&
+      !throttledStates.count(current) && isOverBudget(current)) {
+    throttledStates.insert(current);
+    baseSearcher->removeState(current);
+  }
+
+  if (baseSearcher->empty() && !throttledStates.empty()) {
+    budget *= 2;
+    klee_message("increasing loop iteration budget to: %u", budget);
+    std::vector<ExecutionState*> resumed(throttledStates.begin(),
+                                         throttledStates.end());
+    throttledStates.clear();
+    baseSearcher->update(0, resumed, std::vector<ExecutionState*>());
   }
 }
 
@@ -608,9 +995,94 @@ ExecutionState &InterleavedSearcher::selectState() {
 }
 
 void InterleavedSearcher::update(ExecutionState *current,
-                                 const std::set<ExecutionState*> &addedStates,
-                                 const std::set<ExecutionState*> &removedStates) {
+                                 const std::vector<ExecutionState*> &addedStates,
+                                 const std::vector<ExecutionState*> &removedStates) {
   for (std::vector<Searcher*>::const_iterator it = searchers.begin(),
          ie = searchers.end(); it != ie; ++it)
     (*it)->update(current, addedStates, removedStates);
 }
+
+///
+
+BanditSearcher::BanditSearcher(const std::vector<Searcher*> &_searchers,
+                               double _sliceTime)
+  : sliceTime(_sliceTime),
+    currentArm(0),
+    totalPulls(0),
+    maxReward(0) {
+  for (std::vector<Searcher*>::const_iterator it = _searchers.begin(),
+         ie = _searchers.end(); it != ie; ++it) {
+    Arm arm;
+    arm.searcher = *it;
+    arm.pulls = 0;
+    arm.reward = 0;
+    arms.push_back(arm);
+  }
+  startSlice();
+}
+
+BanditSearcher::~BanditSearcher() {
+  for (std::vector<Arm>::iterator it = arms.begin(), ie = arms.end();
+       it != ie; ++it)
+    delete it->searcher;
+}
+
+uint64_t BanditSearcher::getCoveredEdges() {
+  // Only maintained by the StatsTracker when istats are written.
+  return stats::trueBranches.getValue() + stats::falseBranches.getValue();
+}
+
+void BanditSearcher::endSlice() {
+  // The rate of new edges decreases as exploration goes on, so recent
+  // slices weigh more than a plain average would give them.
+  const double Alpha = 0.25;
+
+  double elapsed = std::max(util::getWallTime() - sliceStart, 1e-6);
+  double rate = (getCoveredEdges() - sliceEdges) / elapsed;
+  Arm &arm = arms[currentArm];
+  arm.reward = arm.pulls ? arm.reward + (rate - arm.reward) * Alpha : rate;
+  ++arm.pulls;
+  ++totalPulls;
+  maxReward = std::max(maxReward, arm.reward);
+}
+
+void BanditSearcher::startSlice() {
+  // Play every arm once, then pick the best upper confidence bound, with
+  // the rewards normalized to [0, 1].
+  currentArm = arms.size();
+  double best = 0;
+  for (unsigned i = 0; i != arms.size(); ++i) {
+    const Arm &arm = arms[i];
+    if (!arm.pulls) {
+      currentArm = i;
+      break;
+    }
+
+    double mean = maxReward > 0 ? arm.reward / maxReward : 0;
+    double score = mean + std::sqrt(2 * std::log((double) totalPulls) /
+                                    arm.pulls);
+    if (currentArm == arms.size() || score > best) {
+      currentArm = i;
+      best = score;
+    }
+  }
+
+  sliceStart = util::getWallTime();
+  sliceEdges = getCoveredEdges();
+}
+
+ExecutionState &BanditSearcher::selectState() {
+  if (util::getWallTime() - sliceStart > sliceTime) {
+    endSlice();
+    startSlice();
+  }
+  return arms[currentArm].searcher->selectState();
+}
+
+void BanditSearcher::update(ExecutionState *current,
+                            const std::vector<ExecutionState*> &addedStates,
+                            const std::vector<ExecutionState*> &removedStates) {
+  for (std::vector<Arm>::iterator it = arms.begin(), ie = arms.end();
+       it != ie; ++it)
+    it->searcher->update(current, addedStates, removedStates);
+}
@@ -10,6 +10,8 @@
 #ifndef KLEE_SEARCHER_H
 #define KLEE_SEARCHER_H
 
+#include "StateSet.h"
+
 #include "llvm/Support/raw_ostream.h"
 #include <vector>
 #include <set>
@@ -27,6 +29,8 @@ namespace klee {
   template<class T> class DiscretePDF;
   class ExecutionState;
   class Executor;
+  struct KFunction;
+  struct KInstruction;
 
   class Searcher {
   public:
@@ -34,9 +38,12 @@ namespace klee {
 
     virtual ExecutionState &selectState() = 0;
 
+    /// update - Notify the searcher of the states added and removed since
+    /// the last call. The vectors are owned by the caller and only valid
+    /// for the duration of the call.
     virtual void update(ExecutionState *current,
-                        const std::set<ExecutionState*> &addedStates,
-                        const std::set<ExecutionState*> &removedStates) = 0;
+                        const std::vector<ExecutionState*> &addedStates,
+                        const std::vector<ExecutionState*> &removedStates) = 0;
 
     virtual bool empty() = 0;
 
@@ -55,15 +62,13 @@ namespace klee {
     // utility functions
 
     void addState(ExecutionState *es, ExecutionState *current = 0) {
-      std::set<ExecutionState*> tmp;
-      tmp.insert(es);
-      update(current, tmp, std::set<ExecutionState*>());
+      std::vector<ExecutionState*> tmp(1, es);
+      update(current, tmp, std::vector<ExecutionState*>());
     }
 
     void removeState(ExecutionState *es, ExecutionState *current = 0) {
-      std::set<ExecutionState*> tmp;
-      tmp.insert(es);
-      update(current, std::set<ExecutionState*>(), tmp);
+      std::vector<ExecutionState*> tmp(1, es);
+      update(current, std::vector<ExecutionState*>(), tmp);
     }
 
     enum CoreSearchType {
@@ -71,12 +76,14 @@ namespace klee {
       BFS,
       RandomState,
       RandomPath,
+      RandomPathUniform,
       NURS_CovNew,
       NURS_MD2U,
       NURS_Depth,
       NURS_ICnt,
       NURS_CPICnt,
-      NURS_QC
+      NURS_QC,
+      Targeted
     };
   };
 
@@ -86,8 +93,8 @@ namespace klee {
   public:
     ExecutionState &selectState();
     void update(ExecutionState *current,
-                const std::set<ExecutionState*> &addedStates,
-                const std::set<ExecutionState*> &removedStates);
+                const std::vector<ExecutionState*> &addedStates,
+                const std::vector<ExecutionState*> &removedStates);
     bool empty() { return states.empty(); }
     void printName(llvm::raw_ostream &os) {
       os << "DFSSearcher\n";
@@ -100,8 +107,8 @@ namespace klee {
   public:
     ExecutionState &selectState();
     void update(ExecutionState *current,
-                const std::set<ExecutionState*> &addedStates,
-                const std::set<ExecutionState*> &removedStates);
+                const std::vector<ExecutionState*> &addedStates,
+                const std::vector<ExecutionState*> &removedStates);
     bool empty() { return states.empty(); }
     void printName(llvm::raw_ostream &os) {
       os << "BFSSearcher\n";
@@ -109,13 +116,13 @@ namespace klee {
   };
 
   class RandomSearcher : public Searcher {
-    std::vector<ExecutionState*> states;
+    StateSet states;
 
   public:
     ExecutionState &selectState();
     void update(ExecutionState *current,
-                const std::set<ExecutionState*> &addedStates,
-                const std::set<ExecutionState*> &removedStates);
+                const std::vector<ExecutionState*> &addedStates,
+                const std::vector<ExecutionState*> &removedStates);
     bool empty() { return states.empty(); }
     void printName(llvm::raw_ostream &os) {
       os << "RandomSearcher\n";
@@ -137,8 +144,18 @@ namespace klee {
     DiscretePDF<ExecutionState*> *states;
     WeightType type;
     bool updateWeights;
+
+    /// All states known to the searcher, used to find the states whose
+    /// coverage information changed.
+    StateSet members;
+    /// States whose weight must be recomputed before the next selection.
+    StateSet dirtyStates;
+    /// The coverage epoch at the time of the last weight refresh, or zero if
+    /// the weights do not depend on coverage.
+    uint64_t lastCoverageEpoch;
     
     double getWeight(ExecutionState*);
+    void refreshWeights();
 
   public:
     WeightedRandomSearcher(WeightType type);
@@ -146,8 +163,8 @@ namespace klee {
 
     ExecutionState &selectState();
     void update(ExecutionState *current,
-                const std::set<ExecutionState*> &addedStates,
-                const std::set<ExecutionState*> &removedStates);
+                const std::vector<ExecutionState*> &addedStates,
+                const std::vector<ExecutionState*> &removedStates);
     bool empty();
     void printName(llvm::raw_ostream &os) {
       os << "WeightedRandomSearcher::";
@@ -163,20 +180,89 @@ namespace klee {
     }
   };
 
+  /// RandomPathSearcher - Select a state by walking down the process tree
+  /// from the root, taking either child of a node with equal probability,
+  /// which favors the states close to the root.
+  ///
+  /// When uniform, the child is instead taken in proportion to the number
+  /// of states below it, so every state has the same probability.
   class RandomPathSearcher : public Searcher {
     Executor &executor;
+    bool uniform;
 
   public:
-    RandomPathSearcher(Executor &_executor);
+    RandomPathSearcher(Executor &_executor, bool _uniform = false);
     ~RandomPathSearcher();
 
     ExecutionState &selectState();
     void update(ExecutionState *current,
-                const std::set<ExecutionState*> &addedStates,
-                const std::set<ExecutionState*> &removedStates);
+                const std::vector<ExecutionState*> &addedStates,
+                const std::vector<ExecutionState*> &removedStates);
     bool empty();
     void printName(llvm::raw_ostream &os) {
-      os << "RandomPathSearcher\n";
+      os << "RandomPathSearcher" << (uniform ? " (uniform)" : "") << "\n";
+    }
+  };
+
+  /// TargetedSearcher - Select the state which is closest to one of a set of
+  /// target source locations, by static distance in instructions through the
+  /// control flow and call graphs (computed as for the min-dist-to-uncovered
+  /// heuristic, see StatsTracker::computeReachableUncovered).
+  class TargetedSearcher : public Searcher {
+    /// Static distances from every instruction of a function, indexed like
+    /// KFunction::instructions. Zero means unreachable.
+    struct FunctionDistances {
+      /// Distance to the closest return instruction.
+      std::vector<uint64_t> toReturn;
+      /// Distance to the closest target, possibly through calls but without
+      /// returning from the function.
+      std::vector<uint64_t> toTarget;
+    };
+
+    struct QueueOrder {
+      bool operator()(const std::pair<uint64_t, ExecutionState*> &a,
+                      const std::pair<uint64_t, ExecutionState*> &b) const;
+    };
+
+    Executor &executor;
+    std::map<const KFunction*, FunctionDistances> distances;
+    std::map<llvm::Instruction*, std::vector<llvm::Function*> > callTargets;
+    unsigned numTargets;
+
+    /// The states ordered by distance to the targets (unreachable last).
+    std::set<std::pair<uint64_t, ExecutionState*>, QueueOrder> queue;
+    /// The distance each state is queued with, indexed by state id.
+    std::vector<uint64_t> stateDistances;
+    /// States which executed since their distance was computed.
+    StateSet dirtyStates;
+
+    void findTargets(const std::vector<std::string> &locations);
+    void computeCallTargets();
+    void computeDistances(bool toTarget);
+    uint64_t getDistance(const KFunction *kf, const KInstruction *ki,
+                         bool toTarget);
+    uint64_t getDistance(ExecutionState *es);
+    void enqueue(ExecutionState *es);
+    void dequeue(ExecutionState *es);
+
+  public:
+    /// \param locations - The targets, as "file:line" strings. The file is
+    /// matched against the suffix of the source path. The instructions
+    /// marked by markChangedCode are targets as well.
+    TargetedSearcher(Executor &_executor,
+                     const std::vector<std::string> &locations);
+
+    /// Return true iff some code of the executor's module was marked as
+    /// changed since a previous version (see --patch-base).
+    static bool hasChangedCode(Executor &executor);
+
+    ExecutionState &selectState();
+    void update(ExecutionState *current,
+                const std::vector<ExecutionState*> &addedStates,
+                const std::vector<ExecutionState*> &removedStates);
+    bool empty() { return queue.empty(); }
+    void printName(llvm::raw_ostream &os) {
+      os << "TargetedSearcher (" << numTargets << " target instructions)\n";
     }
   };
 
@@ -185,6 +271,9 @@ namespace klee {
     std::set<ExecutionState*> statesAtMerge;
     Searcher *baseSearcher;
     llvm::Function *mergeFunction;
+    /// The removed states passed on to the base searcher (reused across
+    /// updates).
+    std::vector<ExecutionState*> alt;
 
   private:
     llvm::Instruction *getMergePoint(ExecutionState &es);
@@ -195,8 +284,8 @@ namespace klee {
 
     ExecutionState &selectState();
     void update(ExecutionState *current,
-                const std::set<ExecutionState*> &addedStates,
-                const std::set<ExecutionState*> &removedStates);
+                const std::vector<ExecutionState*> &addedStates,
+                const std::vector<ExecutionState*> &removedStates);
     bool empty() { return baseSearcher->empty() && statesAtMerge.empty(); }
     void printName(llvm::raw_ostream &os) {
       os << "MergingSearcher\n";
@@ -218,8 +307,8 @@ namespace klee {
 
     ExecutionState &selectState();
     void update(ExecutionState *current,
-                const std::set<ExecutionState*> &addedStates,
-                const std::set<ExecutionState*> &removedStates);
+                const std::vector<ExecutionState*> &addedStates,
+                const std::vector<ExecutionState*> &removedStates);
     bool empty() { return baseSearcher->empty() && statesAtMerge.empty(); }
     void printName(llvm::raw_ostream &os) {
       os << "BumpMergingSearcher\n";
@@ -243,8 +332,8 @@ namespace klee {
 
     ExecutionState &selectState();
     void update(ExecutionState *current,
-                const std::set<ExecutionState*> &addedStates,
-                const std::set<ExecutionState*> &removedStates);
+                const std::vector<ExecutionState*> &addedStates,
+                const std::vector<ExecutionState*> &removedStates);
     bool empty() { return baseSearcher->empty(); }
     void printName(llvm::raw_ostream &os) {
       os << "<BatchingSearcher> timeBudget: " << timeBudget
@@ -259,6 +348,9 @@ namespace klee {
     Searcher *baseSearcher;
     double time, startTime;
     std::set<ExecutionState*> pausedStates;
+    /// The removed states passed on to the base searcher (reused across
+    /// updates).
+    std::vector<ExecutionState*> alt;
 
   public:
     IterativeDeepeningTimeSearcher(Searcher *baseSearcher);
@@ -266,14 +358,46 @@ namespace klee {
 
     ExecutionState &selectState();
     void update(ExecutionState *current,
-                const std::set<ExecutionState*> &addedStates,
-                const std::set<ExecutionState*> &removedStates);
+                const std::vector<ExecutionState*> &addedStates,
+                const std::vector<ExecutionState*> &removedStates);
     bool empty() { return baseSearcher->empty() && pausedStates.empty(); }
     void printName(llvm::raw_ostream &os) {
       os << "IterativeDeepeningTimeSearcher\n";
     }
   };
 
+  /// LoopBudgetSearcher - Hold back the states which have iterated the
+  /// loop they are in more than a budget number of times, until the base
+  /// searcher runs out of other states; the budget is then doubled and the
+  /// held back states resumed.
+  ///
+  /// This keeps input-dependent loops from flooding the search with states
+  /// which only differ in their number of iterations.
+  class LoopBudgetSearcher : public Searcher {
+    Searcher *baseSearcher;
+    unsigned budget;
+    std::set<ExecutionState*> throttledStates;
+    /// The states passed on to the base searcher (reused across updates).
+    std::vector<ExecutionState*> added, removed;
+
+    bool isOverBudget(ExecutionState *es) const;
+
+  public:
+    LoopBudgetSearcher(Searcher *baseSearcher, unsigned budget);
+    ~LoopBudgetSearcher();
+
+    ExecutionState &selectState();
+    void update(ExecutionState *current,
+                const std::vector<ExecutionState*> &addedStates,
+                const std::vector<ExecutionState*> &removedStates);
+    bool empty() { return baseSearcher->empty() && throttledStates.empty(); }
+    void printName(llvm::raw_ostream &os) {
+      os << "<LoopBudgetSearcher> budget: " << budget << "\n";
+      baseSearcher->printName(os);
+      os << "</LoopBudgetSearcher>\n";
+    }
+  };
+
   class InterleavedSearcher : public Searcher {
     typedef std::vector<Searcher*> searchers_ty;
 
@@ -286,8 +410,8 @@ namespace klee {
 
     ExecutionState &selectState();
     void update(ExecutionState *current,
-                const std::set<ExecutionState*> &addedStates,
-                const std::set<ExecutionState*> &removedStates);
+                const std::vector<ExecutionState*> &addedStates,
+                const std::vector<ExecutionState*> &removedStates);
     bool empty() { return searchers[0]->empty(); }
     void printName(llvm::raw_ostream &os) {
       os << "<InterleavedSearcher> containing "
@@ -299,6 +423,57 @@ namespace klee {
     }
   };
 
+  /// BanditSearcher - Like InterleavedSearcher, but instead of taking turns
+  /// the child searchers are treated as the arms of a multi-armed bandit.
+  ///
+  /// Each arm is played for a slice of time and rewarded by the number of
+  /// new branch edges covered per second of the slice (which includes the
+  /// time spent in the solver). The next arm is chosen by UCB1 on the
+  /// recent rewards, so searchers which stop finding new edges are played
+  /// less, without ever being starved.
+  class BanditSearcher : public Searcher {
+    typedef std::vector<Searcher*> searchers_ty;
+
+    struct Arm {
+      Searcher *searcher;
+      unsigned pulls;
+      /// Moving average of the rate of new edges.
+      double reward;
+    };
+
+    std::vector<Arm> arms;
+    double sliceTime;
+    unsigned currentArm;
+    unsigned totalPulls;
+    double maxReward;
+
+    double sliceStart;
+    uint64_t sliceEdges;
+
+    static uint64_t getCoveredEdges();
+    void endSlice();
+    void startSlice();
+
+  public:
+    /// \param _sliceTime - The time for which an arm is played.
+    BanditSearcher(const searchers_ty &_searchers, double _sliceTime);
+    ~BanditSearcher();
+
+    ExecutionState &selectState();
+    void update(ExecutionState *current,
+                const std::vector<ExecutionState*> &addedStates,
+                const std::vector<ExecutionState*> &removedStates);
+    bool empty() { return arms[0].searcher->empty(); }
+    void printName(llvm::raw_ostream &os) {
+      os << "<BanditSearcher> containing "
+         << arms.size() << " searchers:\n";
+      for (std::vector<Arm>::iterator it = arms.begin(), ie = arms.end();
+           it != ie; ++it)
+        it->searcher->printName(os);
+      os << "</BanditSearcher>\n";
+    }
+  };
+
 }
 
 #endif
@@ -0,0 +1,138 @@
+//===-- SolverTimeouts.cpp ------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SolverTimeouts.h"
+#include "CoreStats.h"
+
+#include "llvm/Support/CommandLine.h"
+
+#include <algorithm>
+
+using namespace klee;
+using namespace llvm;
+
+namespace {
+  cl::opt<double>
+  MaxBranchSolverTime("max-branch-solver-time",
+                      cl::desc("Maximum amount of time for a branch query "
+                               "(default=--max-solver-time)"),
+                      cl::init(0.0));
+
+  cl::opt<double>
+  MaxBoundsCheckSolverTime("max-bounds-check-solver-time",
+                           cl::desc("Maximum amount of time for a pointer "
+                                    "resolution or bounds check query "
+                                    "(default=--max-solver-time)"),
+                           cl::init(0.0));
+
+  cl::opt<double>
+  MaxTestGenSolverTime("max-test-gen-solver-time",
+                       cl::desc("Maximum amount of time for computing the "
+                                "inputs of a test case "
+                                "(default=--max-solver-time)"),
+                       cl::init(0.0));
+
+  cl::opt<bool>
+  AdaptiveSolverTimeouts("adaptive-solver-timeouts",
+                         cl::desc("Tune the timeout of each class of queries "
+                                  "from the observed query times, within the "
+                                  "configured timeouts (default=off)"),
+                         cl::init(false));
+
+  cl::opt<double>
+  AdaptiveTimeoutFactor("adaptive-timeout-factor",
+                        cl::desc("Multiple of the 95th percentile query time "
+                                 "used as adaptive timeout (default=4)"),
+                        cl::init(4.0));
+
+  cl::opt<double>
+  MinAdaptiveTimeout("min-adaptive-timeout",
+                     cl::desc("Lower bound of adaptive timeouts, in seconds "
+                              "(default=0.5)"),
+                     cl::init(0.5));
+
+  /// Number of query times kept per class for adaptive timeouts.
+  const unsigned AdaptiveWindow = 256;
+
+  /// Number of queries of a class observed before its timeout is tuned.
+  const unsigned AdaptiveWarmup = 32;
+
+  /// Number of queries of a class recorded between two tunings.
+  const unsigned AdaptiveInterval = 16;
+}
+
+SolverTimeouts::SolverTimeouts(double defaultTimeout) {
+  baseTimeouts[Branch] = MaxBranchSolverTime;
+  baseTimeouts[BoundsCheck] = MaxBoundsCheckSolverTime;
+  baseTimeouts[TestGeneration] = MaxTestGenSolverTime;
+  baseTimeouts[Other] = 0;
+
+  for (unsigned i = 0; i != NumQueryClasses; ++i) {
+    if (!baseTimeouts[i])
+      baseTimeouts[i] = defaultTimeout;
+    timeouts[i] = baseTimeouts[i];
+    nextSample[i] = 0;
+    sinceAdapt[i] = 0;
+  }
+}
+
+bool SolverTimeouts::hasTimeouts() const {
+  if (AdaptiveSolverTimeouts)
+    return true;
+  for (unsigned i = 0; i != NumQueryClasses; ++i)
+    if (baseTimeouts[i])
+      return true;
+  return false;
+}
+
+void SolverTimeouts::recordQuery(QueryClass qc, double elapsed,
+                                 bool timedOut) {
+  if (timedOut) {
+    switch (qc) {
+    case Branch: ++stats::branchQueryTimeouts; break;
+    case BoundsCheck: ++stats::boundsCheckQueryTimeouts; break;
+    case TestGeneration: ++stats::testGenQueryTimeouts; break;
+    default: ++stats::otherQueryTimeouts; break;
+    }
+    // The query would have taken at least as long as the timeout.
+    elapsed = std::max(elapsed, timeouts[qc]);
+  }
+
+  if (!AdaptiveSolverTimeouts)
+    return;
+
+  std::vector<double> &s = samples[qc];
+  if (s.size() < AdaptiveWindow) {
+    s.push_back(elapsed);
+  } else {
+    s[nextSample[qc]] = elapsed;
+    nextSample[qc] = (nextSample[qc] + 1) % AdaptiveWindow;
+  }
+
+  if (s.size() >= AdaptiveWarmup && ++sinceAdapt[qc] >= AdaptiveInterval) {
+    sinceAdapt[qc] = 0;
+    adapt(qc);
+  }
+}
+
+/// adapt - Set the timeout of a class to a multiple of the 95th percentile
+/// of its recent query times, clamped to [MinAdaptiveTimeout, base]. Timed
+/// out queries are recorded with the timeout as their time, so a class
+/// whose queries keep timing out has its timeout grow back to the base.
+void SolverTimeouts::adapt(QueryClass qc) {
+  sorted.assign(samples[qc].begin(), samples[qc].end());
+  unsigned index = (sorted.size() * 95) / 100;
+  std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+
+  double timeout = std::max(sorted[index] * AdaptiveTimeoutFactor,
+                            (double) MinAdaptiveTimeout);
+  if (baseTimeouts[qc])
+    timeout = std::min(timeout, baseTimeouts[qc]);
+  timeouts[qc] = timeout;
+}
@@ -0,0 +1,66 @@
+//===-- SolverTimeouts.h ----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_SOLVERTIMEOUTS_H
+#define KLEE_SOLVERTIMEOUTS_H
+
+#include <vector>
+
+namespace klee {
+
+  /// SolverTimeouts - The timeout budget of each class of solver queries
+  /// made by the executor, optionally tuned from the observed latencies.
+  class SolverTimeouts {
+  public:
+    enum QueryClass {
+      /// Queries deciding the direction of a branch.
+      Branch,
+      /// Pointer resolution and bounds check queries.
+      BoundsCheck,
+      /// Queries computing the inputs of a test case.
+      TestGeneration,
+      /// Anything else (e.g. checking a value is unique).
+      Other,
+      NumQueryClasses
+    };
+
+  private:
+    /// The configured timeout of each class, 0 meaning no timeout.
+    double baseTimeouts[NumQueryClasses];
+    /// The timeout currently in effect for each class.
+    double timeouts[NumQueryClasses];
+    /// The most recent query times of each class, as a ring buffer.
+    std::vector<double> samples[NumQueryClasses];
+    unsigned nextSample[NumQueryClasses];
+    /// The number of queries of each class recorded since its last tuning.
+    unsigned sinceAdapt[NumQueryClasses];
+    /// Scratch copy of a window, reused to find its percentile.
+    std::vector<double> sorted;
+
+    void adapt(QueryClass qc);
+
+  public:
+    /// \param defaultTimeout - The timeout of classes that do not have
+    /// their own (in seconds, 0 for none).
+    explicit SolverTimeouts(double defaultTimeout);
+
+    double getTimeout(QueryClass qc) const { return timeouts[qc]; }
+
+    /// Return true if any class of queries has a timeout.
+    bool hasTimeouts() const;
+
+    /// Record the outcome of a query.
+    ///
+    /// \param elapsed - The wall time the query took (in seconds).
+    /// \param timedOut - Whether the query was stopped by its timeout.
+    void recordQuery(QueryClass qc, double elapsed, bool timedOut);
+  };
+}
+
+#endif
@@ -507,22 +507,15 @@ void SpecialFunctionHandler::handlePrintRange(ExecutionState &state,
   std::string msg_str = readStringAtAddress(state, arguments[0]);
   llvm::errs() << msg_str << ":" << arguments[1];
   if (!isa<ConstantExpr>(arguments[1])) {
-    // FIXME: Pull into a unique value method?
-    ref<ConstantExpr> value;
-    bool success __attribute__ ((unused)) = executor.solver->getValue(state, arguments[1], value);
-    assert(success && "FIXME: Unhandled solver failure");
-    bool res;
-    success = executor.solver->mustBeTrue(state, 
-                                          EqExpr::create(arguments[1], value), 
-                                          res);
+    ref<ConstantExpr> min, max, value;
+    bool success __attribute__ ((unused)) =
+      executor.solver->getRange(state, arguments[1], min, max, value);
     assert(success && "FIXME: Unhandled solver failure");
-    if (res) {
+    if (min == max) {
       llvm::errs() << " == " << value;
     } else { 
       llvm::errs() << " ~= " << value;
-      std::pair< ref<Expr>, ref<Expr> > res =
-        executor.solver->getRange(state, arguments[1]);
-      llvm::errs() << " (in [" << res.first << ", " << res.second <<"])";
+      llvm::errs() << " (in [" << min << ", " << max <<"])";
     }
   }
   llvm::errs() << "\n";
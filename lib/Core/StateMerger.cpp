@@ -0,0 +1,243 @@
+//===-- StateMerger.cpp ---------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "StateMerger.h"
+
+#include "Memory.h"
+
+#include "klee/ExecutionState.h"
+#include "klee/Config/Version.h"
+#include "klee/Internal/Module/Cell.h"
+#include "klee/Internal/Module/KInstruction.h"
+#include "klee/Internal/Module/KModule.h"
+
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 3)
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#else
+#include "llvm/BasicBlock.h"
+#include "llvm/Instructions.h"
+#include "llvm/IntrinsicInst.h"
+#endif
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 5)
+#include "llvm/IR/CFG.h"
+#else
+#include "llvm/Support/CFG.h"
+#endif
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+using namespace klee;
+using namespace llvm;
+
+typedef std::set<BasicBlock*> block_set;
+
+/// Return true if the blocks reachable from bb, without going through stop,
+/// contain a cycle.
+static bool hasCycle(BasicBlock *bb, BasicBlock *stop,
+                     std::map<BasicBlock*, int> &color) {
+  int &c = color[bb];
+  if (c == 1)
+    return true;
+  if (c == 2)
+    return false;
+
+  c = 1;
+  for (succ_iterator it = succ_begin(bb), ie = succ_end(bb); it != ie; ++it)
+    if (*it != stop && hasCycle(*it, stop, color))
+      return true;
+  color[bb] = 2;
+  return false;
+}
+
+StateMerger::StateMerger(unsigned _maxRegionSize, unsigned _maxMergeCost)
+  : maxRegionSize(_maxRegionSize), maxMergeCost(_maxMergeCost) {
+}
+
+StateMerger::~StateMerger() {
+  for (std::map<const BasicBlock*, Region*>::iterator it = regions.begin(),
+         ie = regions.end(); it != ie; ++it)
+    delete it->second;
+}
+
+StateMerger::Region *StateMerger::computeRegion(BasicBlock *bb) {
+  BranchInst *bi = dyn_cast<BranchInst>(bb->getTerminator());
+  if (!bi || bi->isUnconditional())
+    return 0;
+
+  // Collect a bounded part of the graph reachable from the branch. The
+  // region and its merge point have at most one block per instruction.
+  std::vector<BasicBlock*> reachable;
+  block_set seen;
+  reachable.push_back(bb);
+  seen.insert(bb);
+  for (unsigned i = 0; i != reachable.size() &&
+         reachable.size() <= 2 * maxRegionSize; ++i)
+    for (succ_iterator it = succ_begin(reachable[i]),
+           ie = succ_end(reachable[i]); it != ie; ++it)
+      if (seen.insert(*it).second)
+        reachable.push_back(*it);
+
+  // Compute the post-dominators within that part of the graph, treating
+  // the blocks on its boundary as exits. This underapproximates the real
+  // post-dominators, so whatever is found does post-dominate the branch.
+  std::map<BasicBlock*, block_set> pd;
+  std::set<BasicBlock*> internal;
+  for (std::vector<BasicBlock*>::iterator it = reachable.begin(),
+         ie = reachable.end(); it != ie; ++it) {
+    BasicBlock *b = *it;
+    bool isInternal = succ_begin(b) != succ_end(b);
+    for (succ_iterator sit = succ_begin(b), sie = succ_end(b); sit != sie;
+         ++sit)
+      if (!seen.count(*sit))
+        isInternal = false;
+    if (isInternal) {
+      internal.insert(b);
+      pd[b] = seen;
+    } else {
+      pd[b].insert(b);
+    }
+  }
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (std::set<BasicBlock*>::iterator it = internal.begin(),
+           ie = internal.end(); it != ie; ++it) {
+      BasicBlock *b = *it;
+      succ_iterator sit = succ_begin(b), sie = succ_end(b);
+      block_set res = pd[*sit];
+      for (++sit; sit != sie; ++sit) {
+        block_set &other = pd[*sit];
+        block_set tmp;
+        std::set_intersection(res.begin(), res.end(),
+                              other.begin(), other.end(),
+                              std::inserter(tmp, tmp.begin()));
+        res.swap(tmp);
+      }
+      res.insert(b);
+      if (res != pd[b]) {
+        pd[b].swap(res);
+        changed = true;
+      }
+    }
+  }
+
+  // The immediate post-dominator is the one post-dominated by all others.
+  BasicBlock *mergeBlock = 0;
+  block_set &candidates = pd[bb];
+  for (block_set::iterator it = candidates.begin(), ie = candidates.end();
+       it != ie; ++it)
+    if (*it != bb && (!mergeBlock || pd[*it].size() > pd[mergeBlock].size()))
+      mergeBlock = *it;
+  if (!mergeBlock)
+    return 0;
+
+  // The region must not loop back to the branch, or within itself.
+  std::map<BasicBlock*, int> color;
+  color[mergeBlock] = 2;
+  if (hasCycle(bb, mergeBlock, color))
+    return 0;
+
+  Region *region = new Region();
+  region->mergePoint = mergeBlock->getFirstNonPHI();
+  unsigned size = 0;
+  for (std::map<BasicBlock*, int>::iterator it = color.begin(),
+         ie = color.end(); it != ie; ++it) {
+    BasicBlock *b = it->first;
+    if (b == bb)
+      continue;
+    region->blocks.insert(b);
+
+    for (BasicBlock::iterator bit = b->begin(), bie = b->end(); bit != bie;
+         ++bit) {
+      Instruction *i = bit;
+      if (b == mergeBlock && !isa<PHINode>(i))
+        break;
+      if (++size > maxRegionSize) {
+        delete region;
+        return 0;
+      }
+
+      // Anything which may leave the current frame, or change the layout
+      // of memory, prevents merging.
+      switch (i->getOpcode()) {
+      case Instruction::Call:
+        if (isa<DbgInfoIntrinsic>(i))
+          break;
+        // Fall through.
+      case Instruction::Invoke:
+      case Instruction::Alloca:
+      case Instruction::VAArg:
+      case Instruction::IndirectBr:
+        delete region;
+        return 0;
+      default:
+        break;
+      }
+    }
+  }
+
+  return region;
+}
+
+const StateMerger::Region *StateMerger::getRegion(BasicBlock *bb) {
+  std::map<const BasicBlock*, Region*>::iterator it = regions.find(bb);
+  if (it != regions.end())
+    return it->second;
+
+  Region *region = computeRegion(bb);
+  regions.insert(std::make_pair(bb, region));
+  return region;
+}
+
+bool StateMerger::shouldMerge(const ExecutionState &a,
+                              const ExecutionState &b) const {
+  if (a.pc != b.pc || a.stack.size() != b.stack.size())
+    return false;
+
+  // Only the current frame can differ, as regions contain no calls.
+  unsigned cost = 0;
+  const StackFrame &af = a.stack.back(), &bf = b.stack.back();
+  KFunction *kf = af.kf;
+  for (unsigned i = 0; i != kf->numInstructions; ++i) {
+    KInstruction *ki = kf->instructions[i];
+    const ref<Expr> &av = af.locals[ki->dest].value;
+    const ref<Expr> &bv = bf.locals[ki->dest].value;
+    if (av.isNull() || bv.isNull() || av == bv)
+      continue;
+    if (isa<ConstantExpr>(av) && isa<ConstantExpr>(bv) &&
+        ki->inst->getType()->isPointerTy())
+      return false;
+    if (++cost > maxMergeCost)
+      return false;
+  }
+
+  MemoryMap::iterator ai = a.addressSpace.objects.begin();
+  MemoryMap::iterator bi = b.addressSpace.objects.begin();
+  MemoryMap::iterator ae = a.addressSpace.objects.end();
+  MemoryMap::iterator be = b.addressSpace.objects.end();
+  for (; ai != ae && bi != be; ++ai, ++bi) {
+    if (ai->first != bi->first)
+      return false;
+    if (ai->second == bi->second)
+      continue;
+
+    const ObjectState *aos = ai->second;
+    const ObjectState *bos = bi->second;
+    for (unsigned i = 0; i != ai->first->size; ++i)
+      if (aos->read8(i) != bos->read8(i) && ++cost > maxMergeCost)
+        return false;
+  }
+
+  return ai == ae && bi == be;
+}
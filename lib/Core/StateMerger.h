@@ -0,0 +1,74 @@
+//===-- StateMerger.h -------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_STATEMERGER_H
+#define KLEE_STATEMERGER_H
+
+#include <map>
+#include <set>
+
+namespace llvm {
+  class BasicBlock;
+  class Instruction;
+}
+
+namespace klee {
+  class ExecutionState;
+
+  /// StateMerger - Find the branches whose two sides can be executed to
+  /// completion and merged back into a single state, and decide whether
+  /// merging two given states is worth it.
+  ///
+  /// A branch is mergeable when its immediate post-dominator is reached
+  /// through a small acyclic region without calls, allocations or returns.
+  /// The states forked at such a branch can then be driven through the
+  /// region within a single executor step, so the merge is invisible to
+  /// the searchers.
+  class StateMerger {
+  public:
+    struct Region {
+      /// The first non-PHI instruction of the post-dominator of the
+      /// branch, where the states are merged (after the PHI nodes, so the
+      /// incoming block no longer matters).
+      llvm::Instruction *mergePoint;
+      /// The blocks between the branch and the merge point, which includes
+      /// the block of the merge point.
+      std::set<const llvm::BasicBlock*> blocks;
+    };
+
+  private:
+    /// Regions by branch block, null when the branch is not mergeable.
+    std::map<const llvm::BasicBlock*, Region*> regions;
+    unsigned maxRegionSize;
+    unsigned maxMergeCost;
+
+    Region *computeRegion(llvm::BasicBlock *bb);
+
+  public:
+    /// \param maxRegionSize - The maximum number of instructions between a
+    /// branch and its merge point.
+    /// \param maxMergeCost - The maximum number of values made symbolic by a
+    /// merge (see shouldMerge).
+    StateMerger(unsigned maxRegionSize, unsigned maxMergeCost);
+    ~StateMerger();
+
+    /// Return the region of the conditional branch terminating the given
+    /// block, or null if it is not mergeable.
+    const Region *getRegion(llvm::BasicBlock *bb);
+
+    /// Return true if merging the two states (at the same merge point) is
+    /// expected to pay off: the number of registers and memory bytes that
+    /// differ (and would become if-then-else expressions) is bounded, and
+    /// no concrete pointer would become symbolic, as symbolic pointers make
+    /// every later memory access through them fork or query the solver.
+    bool shouldMerge(const ExecutionState &a, const ExecutionState &b) const;
+  };
+}
+
+#endif
@@ -0,0 +1,109 @@
+//===-- StateSet.h ----------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_STATESET_H
+#define KLEE_STATESET_H
+
+#include "klee/ExecutionState.h"
+
+#include <cassert>
+#include <vector>
+
+namespace klee {
+
+  /// StateSet - A set of execution states with constant time insertion,
+  /// removal and membership tests.
+  ///
+  /// The states are kept in a dense vector, which can be handed to the
+  /// searchers as is. The position of each state in that vector is stored
+  /// in a slot vector indexed by the (dense) ExecutionState::id, so no
+  /// allocation happens once the set has reached its peak size. Removal
+  /// moves the last state into the hole, so iteration order is not stable
+  /// across removals.
+  class StateSet {
+  public:
+    typedef std::vector<ExecutionState*> states_ty;
+    typedef states_ty::const_iterator const_iterator;
+    typedef states_ty::const_iterator iterator;
+
+  private:
+    states_ty states;
+    /// For each state id, one plus the position of that state in states, or
+    /// zero if the state is not in the set.
+    std::vector<unsigned> slots;
+
+  public:
+    bool count(const ExecutionState *es) const {
+      return es->id < slots.size() && slots[es->id] != 0;
+    }
+
+    /// insert - Add a state to the set.
+    ///
+    /// \return True if the state was not already in the set.
+    bool insert(ExecutionState *es) {
+      if (es->id >= slots.size())
+        slots.resize(es->id + 1, 0);
+      if (slots[es->id])
+        return false;
+      states.push_back(es);
+      slots[es->id] = states.size();
+      return true;
+    }
+
+    template<typename InputIterator>
+    void insert(InputIterator begin, InputIterator end) {
+      for (; begin != end; ++begin)
+        insert(*begin);
+    }
+
+    /// erase - Remove a state from the set.
+    ///
+    /// \return True if the state was in the set.
+    bool erase(ExecutionState *es) {
+      if (!count(es))
+        return false;
+      unsigned pos = slots[es->id] - 1;
+      ExecutionState *last = states.back();
+      states[pos] = last;
+      slots[last->id] = pos + 1;
+      states.pop_back();
+      slots[es->id] = 0;
+      return true;
+    }
+
+    /// take - Empty the set, moving its states into the given vector. The
+    /// storage of the vector is kept by the set in exchange, so taking the
+    /// states repeatedly with the same vector does not allocate.
+    void take(states_ty &out) {
+      for (const_iterator it = states.begin(), ie = states.end(); it != ie;
+           ++it)
+        slots[(*it)->id] = 0;
+      out.clear();
+      out.swap(states);
+    }
+
+    void clear() {
+      for (const_iterator it = states.begin(), ie = states.end(); it != ie;
+           ++it)
+        slots[(*it)->id] = 0;
+      states.clear();
+    }
+
+    bool empty() const { return states.empty(); }
+    size_t size() const { return states.size(); }
+
+    const_iterator begin() const { return states.begin(); }
+    const_iterator end() const { return states.end(); }
+
+    /// getStates - The states in the set, in no particular order.
+    const states_ty &getStates() const { return states; }
+  };
+}
+
+#endif
@@ -16,6 +16,7 @@
 #include "klee/Internal/Module/KModule.h"
 #include "klee/Internal/Module/KInstruction.h"
 #include "klee/Internal/Support/ModuleUtil.h"
+#include "klee/Internal/Support/SharedBitmap.h"
 #include "klee/Internal/System/MemoryUsage.h"
 #include "klee/Internal/System/Time.h"
 #include "klee/Internal/Support/ErrorHandling.h"
@@ -108,7 +109,23 @@ namespace {
   UseCallPaths("use-call-paths",
 	       cl::init(true),
                cl::desc("Enable calltree tracking for instruction level statistics (default=on)"));
-  
+
+  cl::opt<std::string>
+  SharedCoverage("shared-coverage",
+                 cl::desc("Share the coverage with the other KLEE processes using the same file, so a state only covers new code if no process covered it yet (requires --output-istats)"),
+                 cl::value_desc("file"));
+}
+
+///
+
+static uint64_t coverageEpoch = 0;
+
+static void markCoverageChanged(ExecutionState &es) {
+  es.coverageEpoch = ++coverageEpoch;
+}
+
+uint64_t klee::getCoverageEpoch() {
+  return coverageEpoch;
 }
 
 ///
@@ -117,6 +134,10 @@ bool StatsTracker::useStatistics() {
   return OutputStats || OutputIStats;
 }
 
+bool StatsTracker::useIndexedStatistics() {
+  return OutputIStats;
+}
+
 namespace klee {
   class WriteIStatsTimer : public Executor::Timer {
     StatsTracker *statsTracker;
@@ -184,7 +205,8 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
     numBranches(0),
     fullBranches(0),
     partialBranches(0),
-    updateMinDistToUncovered(_updateMinDistToUncovered) {
+    updateMinDistToUncovered(_updateMinDistToUncovered),
+    sharedCoverage(0) {
   KModule *km = executor.kmodule;
 
   if (!sys::path::is_absolute(objectFilename)) {
@@ -206,6 +228,16 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
   if (OutputIStats)
     theStatisticManager->useIndexedStats(km->infos->getMaxID());
 
+  if (!SharedCoverage.empty()) {
+    if (!OutputIStats)
+      klee_error("--shared-coverage requires --output-istats");
+    sharedCoverage = new SharedBitmap();
+    if (!sharedCoverage->open(SharedCoverage, 3 * km->infos->getMaxID(),
+                              km->computeHash()))
+      klee_error("unable to map shared coverage file: %s (or it was made "
+                 "for another program)", SharedCoverage.c_str());
+  }
+
   for (std::vector<KFunction*>::iterator it = km->functions.begin(), 
          ie = km->functions.end(); it != ie; ++it) {
     KFunction *kf = *it;
@@ -256,6 +288,7 @@ StatsTracker::~StatsTracker() {
     delete statsFile;
   if (istatsFile)
     delete istatsFile;
+  delete sharedCoverage;
 }
 
 void StatsTracker::done() {
@@ -303,15 +336,55 @@ void StatsTracker::stepInstruction(ExecutionState &es) {
         // FIXME: This trick no longer works, we should fix this in the line
         // number propogation.
           es.coveredLines[&ii.file].insert(ii.line);
-	es.coveredNew = true;
-        es.instsSinceCovNew = 1;
+        if (!sharedCoverage || sharedCoverage->set(ii.id)) {
+          es.coveredNew = true;
+          es.instsSinceCovNew = 1;
+          markCoverageChanged(es);
+        }
 	++stats::coveredInstructions;
 	stats::uncoveredInstructions += (uint64_t)-1;
+        if (updateMinDistToUncovered)
+          newlyCoveredFunctions.insert(sf.kf->function);
       }
     }
   }
 }
 
+void StatsTracker::writeCovered(llvm::raw_ostream &os) {
+  if (!OutputIStats)
+    return;
+
+  unsigned maxID = executor.kmodule->infos->getMaxID();
+  for (unsigned id = 0; id != maxID; ++id)
+    if (theStatisticManager->getIndexedValue(stats::coveredInstructions, id))
+      os << id << "\n";
+}
+
+void StatsTracker::markCovered(const std::vector<unsigned> &ids) {
+  if (!OutputIStats)
+    return;
+
+  unsigned maxID = executor.kmodule->infos->getMaxID();
+  for (std::vector<unsigned>::const_iterator it = ids.begin(),
+         ie = ids.end(); it != ie; ++it) {
+    unsigned id = *it;
+    if (id >= maxID ||
+        theStatisticManager->getIndexedValue(stats::coveredInstructions, id) ||
+        !theStatisticManager->getIndexedValue(stats::uncoveredInstructions, id))
+      continue;
+    theStatisticManager->setIndex(id);
+    ++stats::coveredInstructions;
+    stats::uncoveredInstructions += (uint64_t)-1;
+  }
+
+  // The distances are recomputed for the whole module.
+  if (updateMinDistToUncovered) {
+    uncoveredDistances.clear();
+    newlyCoveredFunctions.clear();
+    computeReachableUncovered();
+  }
+}
+
 ///
 
 /* Should be called _after_ the es->pushFrame() */
@@ -351,17 +424,24 @@ void StatsTracker::markBranchVisited(ExecutionState *visitedTrue,
     unsigned id = theStatisticManager->getIndex();
     uint64_t hasTrue = theStatisticManager->getIndexedValue(stats::trueBranches, id);
     uint64_t hasFalse = theStatisticManager->getIndexedValue(stats::falseBranches, id);
+    unsigned maxID = executor.kmodule->infos->getMaxID();
     if (visitedTrue && !hasTrue) {
-      visitedTrue->coveredNew = true;
-      visitedTrue->instsSinceCovNew = 1;
+      if (!sharedCoverage || sharedCoverage->set(maxID + id)) {
+        visitedTrue->coveredNew = true;
+        visitedTrue->instsSinceCovNew = 1;
+        markCoverageChanged(*visitedTrue);
+      }
       ++stats::trueBranches;
       if (hasFalse) { ++fullBranches; --partialBranches; }
       else ++partialBranches;
       hasTrue = 1;
     }
     if (visitedFalse && !hasFalse) {
-      visitedFalse->coveredNew = true;
-      visitedFalse->instsSinceCovNew = 1;
+      if (!sharedCoverage || sharedCoverage->set(2 * maxID + id)) {
+        visitedFalse->coveredNew = true;
+        visitedFalse->instsSinceCovNew = 1;
+        markCoverageChanged(*visitedFalse);
+      }
       ++stats::falseBranches;
       if (hasTrue) { ++fullBranches; --partialBranches; }
       else ++partialBranches;
@@ -388,6 +468,11 @@ void StatsTracker::writeStatsHeader() {
              << "'CexCacheTime',"
              << "'ForkTime',"
              << "'ResolveTime',"
+             << "'BranchQueryTimeouts',"
+             << "'BoundsCheckQueryTimeouts',"
+             << "'TestGenQueryTimeouts',"
+             << "'OtherQueryTimeouts',"
+             << "'ChildUserTime',"
 #ifdef DEBUG
 	     << "'ArrayHashTime',"
 #endif
@@ -418,6 +503,11 @@ void StatsTracker::writeStatsLine() {
              << "," << stats::cexCacheTime / 1000000.
              << "," << stats::forkTime / 1000000.
              << "," << stats::resolveTime / 1000000.
+             << "," << stats::branchQueryTimeouts
+             << "," << stats::boundsCheckQueryTimeouts
+             << "," << stats::testGenQueryTimeouts
+             << "," << stats::otherQueryTimeouts
+             << "," << util::getChildrenUserTime()
 #ifdef DEBUG
              << "," << stats::arrayHashTime / 1000000.
 #endif
@@ -426,7 +516,7 @@ void StatsTracker::writeStatsLine() {
 }
 
 void StatsTracker::updateStateStatistics(uint64_t addend) {
-  for (std::set<ExecutionState*>::iterator it = executor.states.begin(),
+  for (StateSet::const_iterator it = executor.states.begin(),
          ie = executor.states.end(); it != ie; ++it) {
     ExecutionState &state = **it;
     const InstructionInfo &ii = *state.pc->info;
@@ -770,10 +860,43 @@ void StatsTracker::computeReachableUncovered() {
     } while (changed);
   }
 
-  // compute minDistToUncovered, 0 is unreachable
+  // Covering an instruction can only change the distances within its
+  // function, and those of the (transitive) callers, which go through its
+  // entry. These functions are recomputed from scratch, using the current
+  // distances of the other functions.
+  std::set<Function*> affected;
+  std::vector<Function*> worklist;
+  if (uncoveredDistances.empty()) {
+    uncoveredDistances.resize(infos.getMaxID());
+    for (Module::iterator fnIt = m->begin(), fn_ie = m->end();
+         fnIt != fn_ie; ++fnIt)
+      worklist.push_back(fnIt);
+  } else {
+    worklist.assign(newlyCoveredFunctions.begin(),
+                    newlyCoveredFunctions.end());
+  }
+  newlyCoveredFunctions.clear();
+  while (!worklist.empty()) {
+    Function *f = worklist.back();
+    worklist.pop_back();
+    if (!affected.insert(f).second)
+      continue;
+    std::vector<Instruction*> &callers = functionCallers[f];
+    for (std::vector<Instruction*>::iterator it = callers.begin(),
+           ie = callers.end(); it != ie; ++it)
+      worklist.push_back((*it)->getParent()->getParent());
+  }
+  if (affected.empty())
+    return;
+
+  // compute minDistToUncovered, 0 is unreachable. The distances are
+  // computed in uncoveredDistances, and only published to the statistics
+  // once they are final.
   std::vector<Instruction *> instructions;
   for (Module::iterator fnIt = m->begin(), fn_ie = m->end(); 
        fnIt != fn_ie; ++fnIt) {
+    if (!affected.count(fnIt))
+      continue;
     // Not sure if I should bother to preorder here.
     for (Function::iterator bbIt = fnIt->begin(), bb_ie = fnIt->end(); 
          bbIt != bb_ie; ++bbIt) {
@@ -781,9 +904,8 @@ void StatsTracker::computeReachableUncovered() {
            it != ie; ++it) {
         unsigned id = infos.getInfo(it).id;
         instructions.push_back(&*it);
-        sm.setIndexedValue(stats::minDistToUncovered, 
-                           id, 
-                           sm.getIndexedValue(stats::uncoveredInstructions, id));
+        uncoveredDistances[id] =
+          sm.getIndexedValue(stats::uncoveredInstructions, id);
       }
     }
   }
@@ -797,8 +919,7 @@ void StatsTracker::computeReachableUncovered() {
     for (std::vector<Instruction*>::iterator it = instructions.begin(),
            ie = instructions.end(); it != ie; ++it) {
       Instruction *inst = *it;
-      uint64_t best, cur = best = sm.getIndexedValue(stats::minDistToUncovered, 
-                                                     infos.getInfo(inst).id);
+      uint64_t best, cur = best = uncoveredDistances[infos.getInfo(inst).id];
       unsigned bestThrough = 0;
       
       if (isa<CallInst>(inst) || isa<InvokeInst>(inst)) {
@@ -813,8 +934,8 @@ void StatsTracker::computeReachableUncovered() {
           }
 
           if (!(*fnIt)->isDeclaration()) {
-            uint64_t calleeDist = sm.getIndexedValue(stats::minDistToUncovered,
-                                                     infos.getFunctionInfo(*fnIt).id);
+            uint64_t calleeDist =
+              uncoveredDistances[infos.getFunctionInfo(*fnIt).id];
             if (calleeDist) {
               calleeDist = 1+calleeDist; // count instruction itself
               if (best==0 || calleeDist<best)
@@ -830,10 +951,9 @@ void StatsTracker::computeReachableUncovered() {
         std::vector<Instruction*> succs = getSuccs(inst);
         for (std::vector<Instruction*>::iterator it2 = succs.begin(),
                ie = succs.end(); it2 != ie; ++it2) {
-          uint64_t dist = sm.getIndexedValue(stats::minDistToUncovered,
-                                             infos.getInfo(*it2).id);
-          if (dist) {
-            uint64_t val = bestThrough + dist;
+          uint64_t succDist = uncoveredDistances[infos.getInfo(*it2).id];
+          if (succDist) {
+            uint64_t val = bestThrough + succDist;
             if (best==0 || val<best)
               best = val;
           }
@@ -841,15 +961,19 @@ void StatsTracker::computeReachableUncovered() {
       }
 
       if (best != cur) {
-        sm.setIndexedValue(stats::minDistToUncovered, 
-                           infos.getInfo(inst).id, 
-                           best);
+        uncoveredDistances[infos.getInfo(inst).id] = best;
         changed = true;
       }
     }
   } while (changed);
 
-  for (std::set<ExecutionState*>::iterator it = executor.states.begin(),
+  for (std::vector<Instruction*>::iterator it = instructions.begin(),
+         ie = instructions.end(); it != ie; ++it) {
+    unsigned id = infos.getInfo(*it).id;
+    sm.setIndexedValue(stats::minDistToUncovered, id, uncoveredDistances[id]);
+  }
+
+  for (StateSet::const_iterator it = executor.states.begin(),
          ie = executor.states.end(); it != ie; ++it) {
     ExecutionState *es = *it;
     uint64_t currentFrameMinDist = 0;
@@ -869,5 +993,9 @@ void StatsTracker::computeReachableUncovered() {
       
       currentFrameMinDist = computeMinDistToUncovered(kii, currentFrameMinDist);
     }
+
+    // The distances were recomputed for all instructions, so the weight of
+    // every state may have changed.
+    markCoverageChanged(*es);
   }
 }
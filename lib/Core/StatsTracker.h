@@ -13,12 +13,14 @@
 #include "CallPathManager.h"
 
 #include <set>
+#include <vector>
 
 namespace llvm {
   class BranchInst;
   class Function;
   class Instruction;
   class raw_fd_ostream;
+  class raw_ostream;
 }
 
 namespace klee {
@@ -27,6 +29,7 @@ namespace klee {
   class InstructionInfoTable;
   class InterpreterHandler;
   struct KInstruction;
+  class SharedBitmap;
   struct StackFrame;
 
   class StatsTracker {
@@ -46,9 +49,24 @@ namespace klee {
 
     bool updateMinDistToUncovered;
 
+    /// Functions with instructions covered since the distances to uncovered
+    /// instructions were last computed.
+    std::set<llvm::Function*> newlyCoveredFunctions;
+
+    /// The distance to uncovered instructions, by instruction id.
+    std::vector<uint64_t> uncoveredDistances;
+
+    /// The coverage shared with other processes, if any: one bit per
+    /// instruction id, followed by one per true and one per false branch.
+    SharedBitmap *sharedCoverage;
+
   public:
     static bool useStatistics();
 
+    /// Return true if per-instruction statistics (such as coverage) are
+    /// tracked.
+    static bool useIndexedStatistics();
+
   private:
     void updateStateStatistics(uint64_t addend);
     void writeStatsHeader();
@@ -83,11 +101,25 @@ namespace klee {
     double elapsed();
 
     void computeReachableUncovered();
+
+    /// Write the ids of the covered instructions, one per line.
+    void writeCovered(llvm::raw_ostream &os);
+
+    /// Mark the given instructions as covered (when resuming from a
+    /// checkpoint written by writeCovered).
+    void markCovered(const std::vector<unsigned> &ids);
   };
 
   uint64_t computeMinDistToUncovered(const KInstruction *ki,
                                      uint64_t minDistAtRA);
 
+  /// Return the current coverage epoch. The epoch is bumped every time the
+  /// coverage information of a state changes (new coverage, or a new
+  /// distance to uncovered code), and the state's coverageEpoch is set to
+  /// the new value, so searchers can find the states whose weight is stale
+  /// by comparing against the epoch they last looked at.
+  uint64_t getCoverageEpoch();
+
 }
 
 #endif
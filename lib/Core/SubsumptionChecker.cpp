@@ -0,0 +1,178 @@
+//===-- SubsumptionChecker.cpp --------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SubsumptionChecker.h"
+
+#include "Memory.h"
+
+#include "klee/Internal/Module/Cell.h"
+#include "klee/Internal/Module/KInstruction.h"
+#include "klee/Internal/Module/KModule.h"
+
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 3)
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#else
+#include "llvm/BasicBlock.h"
+#include "llvm/Function.h"
+#endif
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 5)
+#include "llvm/IR/CFG.h"
+#else
+#include "llvm/Support/CFG.h"
+#endif
+
+using namespace klee;
+using namespace llvm;
+
+SubsumptionChecker::Snapshot::Snapshot(unsigned _hash,
+                                       const ExecutionState &state)
+  : hash(_hash),
+    pc(state.pc),
+    incomingBBIndex(state.incomingBBIndex),
+    stack(state.stack),
+    addressSpace(state.addressSpace),
+    constraints(state.constraints) {
+}
+
+SubsumptionChecker::SubsumptionChecker(KModule *kmodule,
+                                       unsigned _maxSnapshots)
+  : maxSnapshots(_maxSnapshots) {
+  // Without loop information, a loop header is approximated as a block
+  // which is the target of a backward edge in the layout order (which is
+  // the case of the headers of the loops emitted by the front-end).
+  for (std::vector<KFunction*>::iterator it = kmodule->functions.begin(),
+         ie = kmodule->functions.end(); it != ie; ++it) {
+    Function *f = (*it)->function;
+    std::map<const BasicBlock*, unsigned> order;
+    for (Function::iterator bb = f->begin(), bbe = f->end(); bb != bbe; ++bb)
+      order.insert(std::make_pair(bb, order.size()));
+
+    for (Function::iterator bb = f->begin(), bbe = f->end(); bb != bbe; ++bb)
+      for (pred_iterator pi = pred_begin(bb), pe = pred_end(bb); pi != pe;
+           ++pi)
+        if (order[*pi] >= order[bb])
+          loopHeaders.insert(bb);
+  }
+}
+
+SubsumptionChecker::~SubsumptionChecker() {
+  for (std::deque<Snapshot*>::iterator it = snapshots.begin(),
+         ie = snapshots.end(); it != ie; ++it)
+    delete *it;
+}
+
+unsigned SubsumptionChecker::hashState(const ExecutionState &state) {
+  unsigned res = (unsigned) (unsigned long) (KInstruction*) state.pc;
+  res = res * Expr::MAGIC_HASH_CONSTANT + state.incomingBBIndex;
+
+  for (ExecutionState::stack_ty::const_iterator it = state.stack.begin(),
+         ie = state.stack.end(); it != ie; ++it) {
+    res = res * Expr::MAGIC_HASH_CONSTANT +
+      (unsigned) (unsigned long) (KInstruction*) it->caller;
+    for (unsigned i = 0; i != it->kf->numRegisters; ++i) {
+      const ref<Expr> &value = it->locals[i].value;
+      res = res * Expr::MAGIC_HASH_CONSTANT +
+        (value.isNull() ? 0 : value->hash());
+    }
+  }
+
+  return res * Expr::MAGIC_HASH_CONSTANT +
+    state.addressSpace.getContentHash();
+}
+
+static bool isSameValue(const ref<Expr> &a, const ref<Expr> &b) {
+  if (a.isNull() || b.isNull())
+    return a.isNull() && b.isNull();
+  return a == b;
+}
+
+bool SubsumptionChecker::isSameProgramState(const Snapshot &s,
+                                            const ExecutionState &state) {
+  if (s.pc != state.pc || s.incomingBBIndex != state.incomingBBIndex ||
+      s.stack.size() != state.stack.size())
+    return false;
+
+  for (unsigned i = 0; i != s.stack.size(); ++i) {
+    const StackFrame &a = s.stack[i], &b = state.stack[i];
+    if (a.kf != b.kf || a.caller != b.caller || a.varargs != b.varargs)
+      return false;
+    for (unsigned j = 0; j != a.kf->numRegisters; ++j)
+      if (!isSameValue(a.locals[j].value, b.locals[j].value))
+        return false;
+  }
+
+  const MemoryMap &ma = s.addressSpace.objects;
+  const MemoryMap &mb = state.addressSpace.objects;
+  if (ma.size() != mb.size())
+    return false;
+  for (MemoryMap::iterator ia = ma.begin(), ib = mb.begin(), ie = ma.end();
+       ia != ie; ++ia, ++ib) {
+    if (ia->first != ib->first)
+      return false;
+    const ObjectState *a = ia->second, *b = ib->second;
+    if (a == b)
+      continue;
+    if (a->getContentHash() != b->getContentHash())
+      return false;
+    for (unsigned i = 0; i != a->size; ++i)
+      if (a->read8(i) != b->read8(i))
+        return false;
+  }
+
+  return true;
+}
+
+void SubsumptionChecker::findCandidates(const ExecutionState &state,
+                                        std::vector< ref<Expr> > &
+                                          conditions) {
+  unsigned hash = hashState(state);
+  std::pair<table_ty::iterator, table_ty::iterator> range =
+    table.equal_range(hash);
+  if (range.first == range.second)
+    return;
+
+  std::set< ref<Expr> > constraints(state.constraints.begin(),
+                                    state.constraints.end());
+  for (table_ty::iterator it = range.first; it != range.second; ++it) {
+    const Snapshot &s = *it->second;
+    if (!isSameProgramState(s, state))
+      continue;
+
+    ref<Expr> condition = ConstantExpr::alloc(1, Expr::Bool);
+    for (ConstraintManager::const_iterator cit = s.constraints.begin(),
+           cie = s.constraints.end(); cit != cie; ++cit)
+      if (!constraints.count(*cit))
+        condition = AndExpr::create(condition, *cit);
+    conditions.push_back(condition);
+  }
+}
+
+void SubsumptionChecker::record(const ExecutionState &state) {
+  if (!maxSnapshots)
+    return;
+
+  if (snapshots.size() >= maxSnapshots) {
+    Snapshot *oldest = snapshots.front();
+    snapshots.pop_front();
+    std::pair<table_ty::iterator, table_ty::iterator> range =
+      table.equal_range(oldest->hash);
+    for (table_ty::iterator it = range.first; it != range.second; ++it) {
+      if (it->second == oldest) {
+        table.erase(it);
+        break;
+      }
+    }
+    delete oldest;
+  }
+
+  Snapshot *s = new Snapshot(hashState(state), state);
+  snapshots.push_back(s);
+  table.insert(std::make_pair(s->hash, s));
+}
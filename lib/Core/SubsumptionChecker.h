@@ -0,0 +1,94 @@
+//===-- SubsumptionChecker.h ------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_SUBSUMPTIONCHECKER_H
+#define KLEE_SUBSUMPTIONCHECKER_H
+
+#include "AddressSpace.h"
+
+#include "klee/Constraints.h"
+#include "klee/ExecutionState.h"
+
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace llvm {
+  class BasicBlock;
+}
+
+namespace klee {
+  class KModule;
+
+  /// SubsumptionChecker - Record snapshots of the states reaching loop
+  /// headers, to find the states which are subsumed by an earlier one.
+  ///
+  /// A state is subsumed by a snapshot when both are at the same program
+  /// point with the same stack and memory, and the constraints of the state
+  /// imply those of the snapshot: every path from the state is then also a
+  /// path from the snapshot, which is (or was) explored by the state it was
+  /// taken from.
+  ///
+  /// Snapshots are looked up by a hash of the program point, stack and
+  /// memory. The hash of the memory is kept up to date by the address
+  /// space, which only rehashes the objects written since the last check
+  /// (see AddressSpace::getContentHash).
+  class SubsumptionChecker {
+    struct Snapshot {
+      unsigned hash;
+      KInstIterator pc;
+      unsigned incomingBBIndex;
+      ExecutionState::stack_ty stack;
+      AddressSpace addressSpace;
+      ConstraintManager constraints;
+
+      Snapshot(unsigned _hash, const ExecutionState &state);
+    };
+
+    typedef std::multimap<unsigned, Snapshot*> table_ty;
+
+    /// The loop headers of the module, the only points where states are
+    /// checked.
+    std::set<const llvm::BasicBlock*> loopHeaders;
+    table_ty table;
+    /// The snapshots, oldest first, for eviction.
+    std::deque<Snapshot*> snapshots;
+    unsigned maxSnapshots;
+
+    static unsigned hashState(const ExecutionState &state);
+    static bool isSameProgramState(const Snapshot &s,
+                                   const ExecutionState &state);
+
+  public:
+    /// \param maxSnapshots - The number of snapshots to keep, the oldest
+    /// ones being evicted first.
+    SubsumptionChecker(KModule *kmodule, unsigned maxSnapshots);
+    ~SubsumptionChecker();
+
+    /// Return true iff states entering the given basic block should be
+    /// checked.
+    bool isCheckPoint(const llvm::BasicBlock *bb) const {
+      return loopHeaders.count(bb);
+    }
+
+    /// Find the snapshots with the same program point, stack and memory as
+    /// the state. For each, add to conditions the conjunction of the
+    /// snapshot constraints that the state does not have (true if there
+    /// are none): the state is subsumed if its constraints imply any of
+    /// them.
+    void findCandidates(const ExecutionState &state,
+                        std::vector< ref<Expr> > &conditions);
+
+    /// Record a snapshot of the state.
+    void record(const ExecutionState &state);
+  };
+}
+
+#endif
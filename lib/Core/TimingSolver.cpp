@@ -116,6 +116,62 @@ bool TimingSolver::getValue(const ExecutionState& state, ref<Expr> expr,
   return success;
 }
 
+bool TimingSolver::getValues(const ExecutionState& state,
+                             const std::vector< ref<Expr> > &exprs,
+                             std::vector< ref<ConstantExpr> > &results) {
+  std::vector< ref<Expr> > simplified;
+  simplified.reserve(exprs.size());
+  bool allConstant = true;
+  for (std::vector< ref<Expr> >::const_iterator it = exprs.begin(),
+         ie = exprs.end(); it != ie; ++it) {
+    ref<Expr> e = *it;
+    if (simplifyExprs && !isa<ConstantExpr>(e))
+      e = state.constraints.simplifyExpr(e);
+    allConstant &= isa<ConstantExpr>(e);
+    simplified.push_back(e);
+  }
+
+  // Fast path, to avoid timer and OS overhead.
+  if (allConstant)
+    return solver->getValues(state.constraints, simplified, results);
+
+  sys::TimeValue now = util::getWallTimeVal();
+
+  bool success = solver->getValues(state.constraints, simplified, results);
+
+  sys::TimeValue delta = util::getWallTimeVal();
+  delta -= now;
+  stats::solverTime += delta.usec();
+  state.queryCost += delta.usec()/1000000.;
+
+  return success;
+}
+
+bool TimingSolver::getUniqueValue(const ExecutionState& state, ref<Expr> expr,
+                                  ref<ConstantExpr> &result, bool &isUnique) {
+  // Fast path, to avoid timer and OS overhead.
+  if (ConstantExpr *CE = dyn_cast<ConstantExpr>(expr)) {
+    result = CE;
+    isUnique = true;
+    return true;
+  }
+
+  sys::TimeValue now = util::getWallTimeVal();
+
+  if (simplifyExprs)
+    expr = state.constraints.simplifyExpr(expr);
+
+  bool success = solver->getUniqueValue(Query(state.constraints, expr),
+                                        result, isUnique);
+
+  sys::TimeValue delta = util::getWallTimeVal();
+  delta -= now;
+  stats::solverTime += delta.usec();
+  state.queryCost += delta.usec()/1000000.;
+
+  return success;
+}
+
 bool 
 TimingSolver::getInitialValues(const ExecutionState& state, 
                                const std::vector<const Array*>
@@ -143,3 +199,28 @@ std::pair< ref<Expr>, ref<Expr> >
 TimingSolver::getRange(const ExecutionState& state, ref<Expr> expr) {
   return solver->getRange(Query(state.constraints, expr));
 }
+
+bool TimingSolver::getRange(const ExecutionState& state, ref<Expr> expr,
+                            ref<ConstantExpr> &min, ref<ConstantExpr> &max,
+                            ref<ConstantExpr> &sample) {
+  // Fast path, to avoid timer and OS overhead.
+  if (ConstantExpr *CE = dyn_cast<ConstantExpr>(expr)) {
+    min = max = sample = CE;
+    return true;
+  }
+
+  sys::TimeValue now = util::getWallTimeVal();
+
+  if (simplifyExprs)
+    expr = state.constraints.simplifyExpr(expr);
+
+  bool success = solver->getRange(Query(state.constraints, expr),
+                                  min, max, sample);
+
+  sys::TimeValue delta = util::getWallTimeVal();
+  delta -= now;
+  stats::solverTime += delta.usec();
+  state.queryCost += delta.usec()/1000000.;
+
+  return success;
+}
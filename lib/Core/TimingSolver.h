@@ -12,6 +12,7 @@
 
 #include "klee/Expr.h"
 #include "klee/Solver.h"
+#include "klee/SolverImpl.h"
 
 #include <vector>
 
@@ -41,6 +42,12 @@ namespace klee {
     void setTimeout(double t) {
       solver->setCoreSolverTimeout(t);
     }
+
+    /// Return true if the last query failed because it ran out of time.
+    bool hasTimedOut() {
+      return solver->impl->getOperationStatusCode() ==
+        SolverImpl::SOLVER_RUN_STATUS_TIMEOUT;
+    }
     
     char *getConstraintLog(const Query& query) {
       return solver->getConstraintLog(query);
@@ -59,12 +66,23 @@ namespace klee {
     bool getValue(const ExecutionState &, ref<Expr> expr, 
                   ref<ConstantExpr> &result);
 
+    bool getValues(const ExecutionState &,
+                   const std::vector< ref<Expr> > &exprs,
+                   std::vector< ref<ConstantExpr> > &results);
+
+    bool getUniqueValue(const ExecutionState &, ref<Expr> expr,
+                        ref<ConstantExpr> &result, bool &isUnique);
+
     bool getInitialValues(const ExecutionState&, 
                           const std::vector<const Array*> &objects,
                           std::vector< std::vector<unsigned char> > &result);
 
     std::pair< ref<Expr>, ref<Expr> >
     getRange(const ExecutionState&, ref<Expr> query);
+
+    bool getRange(const ExecutionState&, ref<Expr> expr,
+                  ref<ConstantExpr> &min, ref<ConstantExpr> &max,
+                  ref<ConstantExpr> &sample);
   };
 
 }
@@ -25,14 +25,21 @@ namespace {
 			clEnumValN(Searcher::BFS, "bfs", "use Breadth First Search (BFS)"),
 			clEnumValN(Searcher::RandomState, "random-state", "randomly select a state to explore"),
 			clEnumValN(Searcher::RandomPath, "random-path", "use Random Path Selection (see OSDI'08 paper)"),
+			clEnumValN(Searcher::RandomPathUniform, "random-path-uniform", "use Random Path Selection, weighting each subtree by its number of states"),
 			clEnumValN(Searcher::NURS_CovNew, "nurs:covnew", "use Non Uniform Random Search (NURS) with Coverage-New"),
 			clEnumValN(Searcher::NURS_MD2U, "nurs:md2u", "use NURS with Min-Dist-to-Uncovered"),
 			clEnumValN(Searcher::NURS_Depth, "nurs:depth", "use NURS with 2^depth"),
 			clEnumValN(Searcher::NURS_ICnt, "nurs:icnt", "use NURS with Instr-Count"),
 			clEnumValN(Searcher::NURS_CPICnt, "nurs:cpicnt", "use NURS with CallPath-Instr-Count"),
 			clEnumValN(Searcher::NURS_QC, "nurs:qc", "use NURS with Query-Cost"),
+			clEnumValN(Searcher::Targeted, "targeted", "select the state closest to the --target-locations"),
 			clEnumValEnd));
 
+  cl::list<std::string>
+  TargetLocations("target-locations",
+                  cl::desc("Comma separated list of file:line locations to direct --search=targeted towards"),
+                  cl::CommaSeparated);
+
   cl::opt<bool>
   UseIterativeDeepeningTimeSearch("use-iterative-deepening-time-search", 
                                     cl::desc("(experimental)"));
@@ -53,6 +60,20 @@ namespace {
             cl::init(5.0));
 
 
+  cl::opt<bool>
+  UseBanditSearch("use-bandit-search",
+                  cl::desc("When several searchers are given with --search, choose among them adaptively by the rate of new branch edges (requires istats), instead of taking turns"));
+
+  cl::opt<double>
+  BanditSliceTime("bandit-slice-time",
+                  cl::desc("Amount of time for which a searcher is used when using --use-bandit-search (default=1.0)"),
+                  cl::init(1.0));
+
+  cl::opt<unsigned>
+  LoopIterationBudget("loop-iteration-budget",
+                      cl::desc("Hold back states which iterated a loop more than this many times, until no other states are left; the budget is then doubled (default=0 (off))"),
+                      cl::init(0));
+
   cl::opt<bool>
   UseMerge("use-merge", 
            cl::desc("Enable support for klee_merge() (experimental)"));
@@ -80,12 +101,14 @@ Searcher *getNewSearcher(Searcher::CoreSearchType type, Executor &executor) {
   case Searcher::BFS: searcher = new BFSSearcher(); break;
   case Searcher::RandomState: searcher = new RandomSearcher(); break;
   case Searcher::RandomPath: searcher = new RandomPathSearcher(executor); break;
+  case Searcher::RandomPathUniform: searcher = new RandomPathSearcher(executor, true); break;
   case Searcher::NURS_CovNew: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::CoveringNew); break;
   case Searcher::NURS_MD2U: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::MinDistToUncovered); break;
   case Searcher::NURS_Depth: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::Depth); break;
   case Searcher::NURS_ICnt: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::InstCount); break;
   case Searcher::NURS_CPICnt: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::CPInstCount); break;
   case Searcher::NURS_QC: searcher = new WeightedRandomSearcher(WeightedRandomSearcher::QueryCost); break;
+  case Searcher::Targeted: searcher = new TargetedSearcher(executor, TargetLocations); break;
   }
 
   return searcher;
@@ -96,7 +119,10 @@ Searcher *klee::constructUserSearcher(Executor &executor) {
   // default values
   if (CoreSearch.size() == 0) {
     CoreSearch.push_back(Searcher::RandomPath);
-    CoreSearch.push_back(Searcher::NURS_CovNew);
+    if (TargetedSearcher::hasChangedCode(executor))
+      CoreSearch.push_back(Searcher::Targeted);
+    else
+      CoreSearch.push_back(Searcher::NURS_CovNew);
   }
 
   Searcher *searcher = getNewSearcher(CoreSearch[0], executor);
@@ -108,7 +134,10 @@ Searcher *klee::constructUserSearcher(Executor &executor) {
     for (unsigned i=1; i<CoreSearch.size(); i++)
       s.push_back(getNewSearcher(CoreSearch[i], executor));
     
-    searcher = new InterleavedSearcher(s);
+    if (UseBanditSearch)
+      searcher = new BanditSearcher(s, BanditSliceTime);
+    else
+      searcher = new InterleavedSearcher(s);
   }
 
   if (UseBatchingSearch) {
@@ -119,6 +148,7 @@ Searcher *klee::constructUserSearcher(Executor &executor) {
   if (UseMerge) {
     assert(!UseBumpMerge);
     assert(std::find(CoreSearch.begin(), CoreSearch.end(), Searcher::RandomPath) == CoreSearch.end()); // XXX: needs further debugging: test/Features/Searchers.c fails with this searcher
+    assert(std::find(CoreSearch.begin(), CoreSearch.end(), Searcher::RandomPathUniform) == CoreSearch.end());
     searcher = new MergingSearcher(executor, searcher);
   } else if (UseBumpMerge) {
     searcher = new BumpMergingSearcher(executor, searcher);
@@ -128,6 +158,10 @@ Searcher *klee::constructUserSearcher(Executor &executor) {
     searcher = new IterativeDeepeningTimeSearcher(searcher);
   }
 
+  if (LoopIterationBudget) {
+    searcher = new LoopBudgetSearcher(searcher, LoopIterationBudget);
+  }
+
   llvm::raw_ostream &os = executor.getHandler().getInfoStream();
 
   os << "BEGIN searcher description\n";
@@ -43,6 +43,9 @@
 #include "llvm/Analysis/DebugInfo.h"
 #endif
 
+#include <fstream>
+#include <vector>
+
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/Support/ErrorHandling.h"
 
@@ -151,6 +154,83 @@ InstructionInfoTable::InstructionInfoTable(Module *m)
   }
 }
 
+InstructionInfoTable::InstructionInfoTable()
+  : dummyString(""), dummyInfo(0, dummyString, 0, 0) {
+}
+
+// The file starts with the number of source files and instructions, then
+// lists the source files, one per line, and finally the source file index
+// (0 for none), source line and assembly line of each instruction, in
+// module order.
+
+InstructionInfoTable *InstructionInfoTable::read(Module *m,
+                                                 const std::string &path) {
+  std::ifstream f(path.c_str());
+  unsigned numFiles, numInstructions;
+  if (!(f >> numFiles >> numInstructions))
+    return 0;
+  f.ignore(1);
+
+  InstructionInfoTable *table = new InstructionInfoTable();
+  std::vector<const std::string *> files(1, &table->dummyString);
+  for (unsigned i = 0; i != numFiles; ++i) {
+    std::string file;
+    std::getline(f, file);
+    files.push_back(table->internString(file));
+  }
+
+  unsigned id = 0;
+  for (Module::iterator fnIt = m->begin(), fn_ie = m->end();
+       fnIt != fn_ie; ++fnIt) {
+    for (inst_iterator it = inst_begin(fnIt), ie = inst_end(fnIt); it != ie;
+         ++it) {
+      unsigned file, line, assemblyLine;
+      if (id == numInstructions || !(f >> file >> line >> assemblyLine) ||
+          file > numFiles) {
+        delete table;
+        return 0;
+      }
+      table->infos.insert(std::make_pair(&*it,
+                                         InstructionInfo(id++, *files[file],
+                                                         line, assemblyLine)));
+    }
+  }
+
+  if (id != numInstructions) {
+    delete table;
+    return 0;
+  }
+  return table;
+}
+
+bool InstructionInfoTable::write(Module *m, const std::string &path) const {
+  std::ofstream f(path.c_str());
+  f << internedStrings.size() << " " << infos.size() << "\n";
+
+  std::map<const std::string *, unsigned> fileIndices;
+  unsigned index = 0;
+  for (std::set<const std::string *, ltstr>::const_iterator
+         it = internedStrings.begin(), ie = internedStrings.end();
+       it != ie; ++it) {
+    fileIndices.insert(std::make_pair(*it, ++index));
+    f << **it << "\n";
+  }
+
+  for (Module::iterator fnIt = m->begin(), fn_ie = m->end();
+       fnIt != fn_ie; ++fnIt) {
+    for (inst_iterator it = inst_begin(fnIt), ie = inst_end(fnIt); it != ie;
+         ++it) {
+      const InstructionInfo &info = getInfo(&*it);
+      std::map<const std::string *, unsigned>::iterator file =
+        fileIndices.find(&info.file);
+      f << (file == fileIndices.end() ? 0 : file->second) << " "
+        << info.line << " " << info.assemblyLine << "\n";
+    }
+  }
+
+  return f.good();
+}
+
 InstructionInfoTable::~InstructionInfoTable() {
   for (std::set<const std::string *, ltstr>::iterator
          it = internedStrings.begin(), ie = internedStrings.end();
@@ -42,13 +42,20 @@
 #endif
 
 #if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
+#include "llvm/Analysis/Dominators.h"
 #include "llvm/Support/CallSite.h"
+#include "llvm/Support/CFG.h"
 #else
 #include "llvm/IR/CallSite.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
 #endif
 
+#include "llvm/Analysis/LoopInfo.h"
+
 #include "llvm/PassManager.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/raw_os_ostream.h"
 #include "llvm/Support/Path.h"
@@ -56,7 +63,16 @@
 
 #include <llvm/Transforms/Utils/Cloning.h>
 
+#if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
+#include "llvm/ADT/OwningPtr.h"
+#endif
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
 #include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace llvm;
 using namespace klee;
@@ -99,6 +115,11 @@ namespace {
   cl::opt<bool>
   DebugPrintEscapingFunctions("debug-print-escaping-functions", 
                               cl::desc("Print functions whose address is taken."));
+
+  cl::opt<std::string>
+  ModuleCache("module-cache",
+              cl::desc("Save the prepared module in the given directory, and reuse it while the input module, runtime and options preparing it are unchanged"),
+              cl::value_desc("directory"));
 }
 
 KModule::KModule(Module *_module) 
@@ -133,6 +154,109 @@ KModule::~KModule() {
 
 namespace llvm {
 extern void Optimize(Module*);
+extern unsigned getOptimizeFlags();
+}
+
+/// 64-bit FNV-1a hash of the given data.
+static uint64_t hashData(const std::string &data) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (std::string::const_iterator it = data.begin(), ie = data.end();
+       it != ie; ++it)
+    hash = (hash ^ (unsigned char) *it) * 1099511628211ULL;
+  return hash;
+}
+
+/// Return the path, without extension, of the cache entry for the module
+/// prepared with the given options. It is named by a hash of everything
+/// the prepared module depends on: the module itself (linked with the
+/// libraries and runtime), the intrinsics library and the options.
+static std::string getCacheEntry(Module *m, const std::string &intrinsicLib,
+                                 const Interpreter::ModuleOptions &opts) {
+  std::string data;
+  llvm::raw_string_ostream os(data);
+  WriteBitcodeToFile(m, os);
+  std::ifstream lib(intrinsicLib.c_str(), std::ios::in | std::ios::binary);
+  std::ostringstream libData;
+  libData << lib.rdbuf();
+  os << libData.str();
+  os << LLVM_VERSION_CODE << " " << opts.Optimize << opts.CheckDivZero
+     << opts.CheckOvershift << " " << getOptimizeFlags() << " "
+     << (int) SwitchType << " " << (int) NoTruncateSourceLines;
+  for (cl::list<std::string>::iterator it = MergeAtExit.begin(),
+         ie = MergeAtExit.end(); it != ie; ++it)
+    os << " " << *it;
+  os.flush();
+
+  std::ostringstream entry;
+  entry << ModuleCache << "/" << std::hex << std::setw(16)
+        << std::setfill('0') << hashData(data);
+  return entry.str();
+}
+
+static Module *loadBitcodeFile(const std::string &path) {
+#if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
+  OwningPtr<MemoryBuffer> buffer;
+  if (MemoryBuffer::getFile(path, buffer))
+    return 0;
+  std::string error;
+  return ParseBitcodeFile(buffer.get(), getGlobalContext(), &error);
+#else
+  ErrorOr<std::unique_ptr<MemoryBuffer> > buffer = MemoryBuffer::getFile(path);
+  if (!buffer)
+    return 0;
+  ErrorOr<Module *> module = parseBitcodeFile(buffer->get(),
+                                              getGlobalContext());
+  return module ? *module : 0;
+#endif
+}
+
+/// Write a file of the cache through a temporary file, so that it is
+/// complete whenever it exists.
+static bool writeCacheFile(const std::string &path, const std::string &data) {
+  std::ostringstream tmp;
+  tmp << path << ".tmp" << getpid();
+  {
+    std::ofstream f(tmp.str().c_str(), std::ios::out | std::ios::binary);
+    f << data;
+    if (!f.good())
+      return false;
+  }
+  return rename(tmp.str().c_str(), path.c_str()) == 0;
+}
+
+/// Write the assembly of the module. We truncate long lines to work
+/// around a kcachegrind parsing bug (it puts them on new lines), so that
+/// source browsing works.
+static void writeAssembly(Module *m, llvm::raw_ostream &os) {
+  // We have an option for this in case the user wants a .ll they
+  // can compile.
+  if (NoTruncateSourceLines) {
+    os << *m;
+    return;
+  }
+
+  std::string string;
+  llvm::raw_string_ostream rss(string);
+  rss << *m;
+  rss.flush();
+  const char *position = string.c_str();
+
+  for (;;) {
+    const char *end = index(position, '\n');
+    if (!end) {
+      os << position;
+      break;
+    } else {
+      unsigned count = (end - position) + 1;
+      if (count<255) {
+        os.write(position, count);
+      } else {
+        os.write(position, 254);
+        os << "\n";
+      }
+      position = end+1;
+    }
+  }
 }
 
 // what a hack
@@ -239,8 +363,48 @@ void KModule::addInternalFunction(const char* functionName){
   internalFunctions.insert(internalFunction);
 }
 
-void KModule::prepare(const Interpreter::ModuleOptions &opts,
-                      InterpreterHandler *ih) {
+bool KModule::loadFromCache(const std::string &entry) {
+  Module *cached = loadBitcodeFile(entry + ".bc");
+  if (!cached)
+    return false;
+
+  std::ifstream assembly((entry + ".ll").c_str());
+  InstructionInfoTable *table =
+    InstructionInfoTable::read(cached, entry + ".info");
+  if (!assembly.good() || !table) {
+    delete table;
+    delete cached;
+    return false;
+  }
+
+  delete module;
+  module = cached;
+  infos = table;
+  return true;
+}
+
+void KModule::saveToCache(const std::string &entry,
+                          const std::string &assembly) {
+  std::string bitcode;
+  llvm::raw_string_ostream os(bitcode);
+  WriteBitcodeToFile(module, os);
+  os.flush();
+
+  // The bitcode is written last, as its presence marks a complete entry.
+  mkdir(ModuleCache.c_str(), 0775);
+  std::string info = entry + ".info";
+  std::ostringstream tmp;
+  tmp << info << ".tmp" << getpid();
+  if (!infos->write(module, tmp.str()) ||
+      rename(tmp.str().c_str(), info.c_str()) < 0 ||
+      !writeCacheFile(entry + ".ll", assembly) ||
+      !writeCacheFile(entry + ".bc", bitcode))
+    klee_warning("unable to save the prepared module to %s.bc",
+                 entry.c_str());
+}
+
+void KModule::transform(const Interpreter::ModuleOptions &opts,
+                        const std::string &intrinsicLib) {
   if (!MergeAtExit.empty()) {
     Function *mergeFn = module->getFunction("klee_merge");
     if (!mergeFn) {
@@ -336,24 +500,7 @@ void KModule::prepare(const Interpreter::ModuleOptions &opts,
   // FIXME: Find a way that we can test programs without requiring
   // this to be linked in, it makes low level debugging much more
   // annoying.
-
-  SmallString<128> LibPath(opts.LibraryDir);
-  llvm::sys::path::append(LibPath,
-#if LLVM_VERSION_CODE >= LLVM_VERSION(3,3)
-      "kleeRuntimeIntrinsic.bc"
-#else
-      "libkleeRuntimeIntrinsic.bca"
-#endif
-    );
-  module = linkWithLibrary(module, LibPath.str());
-
-  // Add internal functions which are not used to check if instructions
-  // have been already visited
-  if (opts.CheckDivZero)
-    addInternalFunction("klee_div_zero_check");
-  if (opts.CheckOvershift)
-    addInternalFunction("klee_overshift_check");
-
+  module = linkWithLibrary(module, intrinsicLib);
 
   // Needs to happen after linking (since ctors/dtors can be modified)
   // and optimization (since global optimization can rewrite lists).
@@ -386,41 +533,64 @@ void KModule::prepare(const Interpreter::ModuleOptions &opts,
   f = module->getFunction("memset");
   if (f && f->use_empty()) f->eraseFromParent();
 #endif
+}
+
+uint64_t KModule::computeHash() const {
+  std::string data;
+  llvm::raw_string_ostream os(data);
+  WriteBitcodeToFile(module, os);
+  os.flush();
+  return hashData(data);
+}
+
+void KModule::prepare(const Interpreter::ModuleOptions &opts,
+                      InterpreterHandler *ih) {
+  SmallString<128> LibPath(opts.LibraryDir);
+  llvm::sys::path::append(LibPath,
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3,3)
+      "kleeRuntimeIntrinsic.bc"
+#else
+      "libkleeRuntimeIntrinsic.bca"
+#endif
+    );
 
-  // Write out the .ll assembly file. We truncate long lines to work
-  // around a kcachegrind parsing bug (it puts them on new lines), so
-  // that source browsing works.
+  // The cached module already went through all the transformations, and
+  // comes with its instruction table and assembly.
+  std::string cacheEntry;
+  bool cached = false;
+  if (!ModuleCache.empty()) {
+    cacheEntry = getCacheEntry(module, LibPath.str(), opts);
+    cached = loadFromCache(cacheEntry);
+    if (cached)
+      klee_message("using the prepared module %s.bc", cacheEntry.c_str());
+  }
+  if (!cached)
+    transform(opts, LibPath.str());
+
+  // Add internal functions which are not used to check if instructions
+  // have been already visited
+  if (opts.CheckDivZero)
+    addInternalFunction("klee_div_zero_check");
+  if (opts.CheckOvershift)
+    addInternalFunction("klee_overshift_check");
+
+  // Write out the .ll assembly file.
+  std::string assembly;
+  if (!cached && (OutputSource || !cacheEntry.empty())) {
+    llvm::raw_string_ostream os(assembly);
+    writeAssembly(module, os);
+    os.flush();
+  }
   if (OutputSource) {
     llvm::raw_fd_ostream *os = ih->openOutputFile("assembly.ll");
     assert(os && !os->has_error() && "unable to open source output");
-
-    // We have an option for this in case the user wants a .ll they
-    // can compile.
-    if (NoTruncateSourceLines) {
-      *os << *module;
+    if (cached) {
+      std::ifstream f((cacheEntry + ".ll").c_str());
+      std::ostringstream data;
+      data << f.rdbuf();
+      *os << data.str();
     } else {
-      std::string string;
-      llvm::raw_string_ostream rss(string);
-      rss << *module;
-      rss.flush();
-      const char *position = string.c_str();
-
-      for (;;) {
-        const char *end = index(position, '\n');
-        if (!end) {
-          *os << position;
-          break;
-        } else {
-          unsigned count = (end - position) + 1;
-          if (count<255) {
-            os->write(position, count);
-          } else {
-            os->write(position, 254);
-            *os << "\n";
-          }
-          position = end+1;
-        }
-      }
+      *os << assembly;
     }
     delete os;
   }
@@ -435,7 +605,10 @@ void KModule::prepare(const Interpreter::ModuleOptions &opts,
 
   /* Build shadow structures */
 
-  infos = new InstructionInfoTable(module);  
+  if (!infos)
+    infos = new InstructionInfoTable(module);
+  if (!cacheEntry.empty() && !cached)
+    saveToCache(cacheEntry, assembly);
   
   for (Module::iterator it = module->begin(), ie = module->end();
        it != ie; ++it) {
@@ -534,6 +707,34 @@ KFunction::KFunction(llvm::Function *_function,
 
   instructions = new KInstruction*[numInstructions];
 
+  if (!function->empty()) {
+    DominatorTreeBase<BasicBlock> dt(false);
+    dt.recalculate(*function);
+    LoopInfoBase<BasicBlock, Loop> loopInfo;
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 1)
+    loopInfo.Analyze(dt);
+#else
+    loopInfo.Calculate(dt);
+#endif
+    for (llvm::Function::iterator bbit = function->begin(),
+           bbie = function->end(); bbit != bbie; ++bbit) {
+      BasicBlock *bb = bbit;
+      Loop *loop = loopInfo.getLoopFor(bb);
+      if (!loop)
+        continue;
+      BasicBlock *header = loop->getHeader();
+      loopHeaders.insert(std::make_pair(bb, header));
+      if (header == bb) {
+        for (pred_iterator pi = pred_begin(header), pe = pred_end(header);
+             pi != pe; ++pi)
+          if (loop->contains(*pi))
+            backEdges.insert(std::make_pair(*pi, header));
+        if (Loop *outer = loop->getParentLoop())
+          outerLoopHeaders.insert(std::make_pair(header, outer->getHeader()));
+      }
+    }
+  }
+
   std::map<Instruction*, unsigned> registerMap;
 
   // The first arg_size() registers are reserved for formals.
@@ -20,10 +20,12 @@
 
 #if LLVM_VERSION_CODE >= LLVM_VERSION(3, 3)
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IRReader/IRReader.h"
+#include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Object/Archive.h"
 #include "llvm/Object/ObjectFile.h"
@@ -33,9 +35,11 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/DataStream.h"
 #else
+#include "llvm/Constants.h"
 #include "llvm/Function.h"
 #include "llvm/Instructions.h"
 #include "llvm/IntrinsicInst.h"
+#include "llvm/Metadata.h"
 #include "llvm/Module.h"
 #endif
 
@@ -490,3 +494,107 @@ static bool valueIsOnlyCalled(const Value *v) {
 bool klee::functionEscapes(const Function *f) {
   return !valueIsOnlyCalled(f);
 }
+
+/// Append a description of the operand to the fingerprint of a basic block.
+/// Local values are described by their position relative to the user, so
+/// the fingerprint does not depend on value names or numbering.
+static void fingerprintOperand(llvm::raw_ostream &os, const Value *v,
+                               const Instruction *user,
+                               const std::map<const Instruction*,
+                                              unsigned> &positions) {
+  if (const Instruction *i = dyn_cast<Instruction>(v)) {
+    std::map<const Instruction*, unsigned>::const_iterator it =
+      positions.find(i);
+    if (i->getParent() == user->getParent() && it != positions.end())
+      os << " l" << (int) positions.find(user)->second - (int) it->second;
+    else
+      os << " x" << i->getOpcodeName();
+  } else if (const Argument *a = dyn_cast<Argument>(v)) {
+    os << " a" << a->getArgNo();
+  } else if (isa<BasicBlock>(v)) {
+    os << " b";
+  } else if (const GlobalValue *gv = dyn_cast<GlobalValue>(v)) {
+    os << " @" << gv->getName();
+  } else if (const ConstantInt *ci = dyn_cast<ConstantInt>(v)) {
+    os << " i" << ci->getValue().toString(10, true);
+  } else if (const llvm::ConstantExpr *ce = dyn_cast<llvm::ConstantExpr>(v)) {
+    os << " (" << ce->getOpcodeName();
+    for (unsigned j = 0; j != ce->getNumOperands(); ++j)
+      fingerprintOperand(os, ce->getOperand(j), user, positions);
+    os << ")";
+  } else {
+    os << " v" << v->getValueID();
+  }
+}
+
+static std::string fingerprintBlock(const BasicBlock *bb) {
+  std::map<const Instruction*, unsigned> positions;
+  unsigned position = 0;
+  for (BasicBlock::const_iterator it = bb->begin(), ie = bb->end(); it != ie;
+       ++it)
+    positions[it] = position++;
+
+  std::string result;
+  llvm::raw_string_ostream os(result);
+  for (BasicBlock::const_iterator it = bb->begin(), ie = bb->end(); it != ie;
+       ++it) {
+    // Debug intrinsics only carry source locations.
+    if (isa<DbgInfoIntrinsic>(it))
+      continue;
+    os << it->getOpcodeName() << " ";
+    it->getType()->print(os);
+    if (const CmpInst *ci = dyn_cast<CmpInst>(it))
+      os << " p" << ci->getPredicate();
+    for (unsigned j = 0; j != it->getNumOperands(); ++j)
+      fingerprintOperand(os, it->getOperand(j), it, positions);
+    os << ";";
+  }
+  return os.str();
+}
+
+static const char *changedCodeKind = "klee.changed";
+
+unsigned klee::markChangedCode(const Module *base, Module *module) {
+  LLVMContext &ctx = module->getContext();
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 6)
+  MDNode *mark = MDNode::get(ctx, ArrayRef<Metadata*>());
+#else
+  MDNode *mark = MDNode::get(ctx, ArrayRef<Value*>());
+#endif
+
+  unsigned numChanged = 0;
+  for (Module::iterator fnIt = module->begin(), fnIe = module->end();
+       fnIt != fnIe; ++fnIt) {
+    if (fnIt->isDeclaration())
+      continue;
+
+    // Blocks are matched as a multiset, so moving a block or inserting a
+    // new one does not mark the others.
+    std::map<std::string, unsigned> baseBlocks;
+    if (const Function *baseFn = base->getFunction(fnIt->getName()))
+      for (Function::const_iterator bbIt = baseFn->begin(),
+             bbIe = baseFn->end(); bbIt != bbIe; ++bbIt)
+        ++baseBlocks[fingerprintBlock(bbIt)];
+
+    for (Function::iterator bbIt = fnIt->begin(), bbIe = fnIt->end();
+         bbIt != bbIe; ++bbIt) {
+      std::map<std::string, unsigned>::iterator it =
+        baseBlocks.find(fingerprintBlock(bbIt));
+      if (it != baseBlocks.end() && it->second) {
+        --it->second;
+        continue;
+      }
+
+      for (BasicBlock::iterator i = bbIt->begin(), ie = bbIt->end(); i != ie;
+           ++i)
+        i->setMetadata(changedCodeKind, mark);
+      ++numChanged;
+    }
+  }
+
+  return numChanged;
+}
+
+bool klee::isChangedCode(const Instruction *i) {
+  return i->getMetadata(changedCodeKind) != 0;
+}
@@ -294,4 +294,12 @@ void Optimize(Module* M) {
   Passes.run(*M);
 }
 
+/// getOptimizeFlags - Return the options changing the result of Optimize,
+/// as a bit mask (used to tell apart modules optimized differently).
+unsigned getOptimizeFlags() {
+  return (DisableInline ? 1 : 0) | (DisableOptimizations ? 2 : 0) |
+         (DisableInternalize ? 4 : 0) | (Strip ? 8 : 0) |
+         (StripDebug ? 16 : 0);
+}
+
 }
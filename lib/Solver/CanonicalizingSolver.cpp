@@ -0,0 +1,285 @@
+//===-- CanonicalizingSolver.cpp - Canonical form of queries --------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Solver.h"
+
+#include "klee/Constraints.h"
+#include "klee/Expr.h"
+#include "klee/SolverImpl.h"
+#include "klee/util/ArrayCache.h"
+#include "klee/util/ExprHashMap.h"
+#include "klee/util/ExprVisitor.h"
+
+#include "llvm/ADT/StringExtras.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+/// ShapeHasher - Compute a hash of an expression which does not depend on
+/// the identity of the symbolic arrays it reads from, used to order
+/// constraints before their arrays are renamed.
+class ShapeHasher {
+  ExprHashMap<unsigned> cache;
+
+public:
+  unsigned hash(const ref<Expr> &e);
+};
+
+unsigned ShapeHasher::hash(const ref<Expr> &e) {
+  if (isa<ConstantExpr>(e))
+    return e->hash();
+
+  ExprHashMap<unsigned>::iterator it = cache.find(e);
+  if (it != cache.end())
+    return it->second;
+
+  unsigned res = e->getKind() * Expr::MAGIC_HASH_CONSTANT + e->getWidth();
+  if (const ReadExpr *re = dyn_cast<ReadExpr>(e)) {
+    const Array *root = re->updates.root;
+    res = res * Expr::MAGIC_HASH_CONSTANT + root->size;
+    if (root->isConstantArray())
+      res = res * Expr::MAGIC_HASH_CONSTANT + root->hash();
+    for (const UpdateNode *un = re->updates.head; un; un = un->next) {
+      res = res * Expr::MAGIC_HASH_CONSTANT + hash(un->index);
+      res = res * Expr::MAGIC_HASH_CONSTANT + hash(un->value);
+    }
+    res = res * Expr::MAGIC_HASH_CONSTANT + hash(re->index);
+  } else {
+    for (unsigned i = 0, n = e->getNumKids(); i != n; ++i)
+      res = res * Expr::MAGIC_HASH_CONSTANT + hash(e->getKid(i));
+  }
+
+  cache.insert(std::make_pair(e, res));
+  return res;
+}
+
+/// ArrayRenamer - Rewrite expressions so that symbolic arrays are replaced
+/// by canonical ones, numbered in order of first use.
+class ArrayRenamer : public ExprVisitor {
+  ArrayCache &arrayCache;
+  std::map<const UpdateNode*, UpdateList> updateCache;
+
+  UpdateList renameUpdates(const UpdateList &ul);
+
+protected:
+  Action visitRead(const ReadExpr &re);
+
+public:
+  typedef std::map<const Array*, const Array*> array_map_ty;
+
+  /// Map from the original arrays to their canonical replacement.
+  array_map_ty arrayMap;
+
+  ArrayRenamer(ArrayCache &_arrayCache)
+    : arrayCache(_arrayCache) {}
+
+  const Array *getCanonicalArray(const Array *array);
+};
+
+const Array *ArrayRenamer::getCanonicalArray(const Array *array) {
+  if (array->isConstantArray())
+    return array;
+
+  array_map_ty::iterator it = arrayMap.find(array);
+  if (it != arrayMap.end())
+    return it->second;
+
+  // The array cache returns the same array for the same name and size, so
+  // canonical arrays are shared by all queries.
+  std::string name = "canon" + llvm::utostr(arrayMap.size()) + "_" +
+    llvm::utostr(array->getDomain()) + "_" + llvm::utostr(array->getRange());
+  const Array *canonical = arrayCache.CreateArray(name, array->size, 0, 0,
+                                                  array->getDomain(),
+                                                  array->getRange());
+  arrayMap.insert(std::make_pair(array, canonical));
+  return canonical;
+}
+
+UpdateList ArrayRenamer::renameUpdates(const UpdateList &ul) {
+  // Find the longest suffix of the update list which was already renamed,
+  // then replay the remaining writes on top of it (oldest first).
+  std::vector<const UpdateNode*> pending;
+  const UpdateNode *un = ul.head;
+  std::map<const UpdateNode*, UpdateList>::iterator it;
+  for (; un; un = un->next) {
+    it = updateCache.find(un);
+    if (it != updateCache.end())
+      break;
+    pending.push_back(un);
+  }
+
+  UpdateList res = un ? it->second :
+    UpdateList(getCanonicalArray(ul.root), 0);
+  for (std::vector<const UpdateNode*>::reverse_iterator
+         rit = pending.rbegin(), rie = pending.rend(); rit != rie; ++rit) {
+    res.extend(visit((*rit)->index), visit((*rit)->value));
+    updateCache.insert(std::make_pair(*rit, res));
+  }
+  return res;
+}
+
+ExprVisitor::Action ArrayRenamer::visitRead(const ReadExpr &re) {
+  const UpdateList &ul = re.updates;
+  if (ul.root->isConstantArray() && !ul.head)
+    return Action::doChildren();
+
+  // Rename the root before visiting the index, so arrays are numbered in
+  // order of first use.
+  getCanonicalArray(ul.root);
+  UpdateList renamed = renameUpdates(ul);
+  return Action::changeTo(ReadExpr::create(renamed, visit(re.index)));
+}
+
+struct ShapeOrder {
+  const std::vector<unsigned> &hashes;
+
+  ShapeOrder(const std::vector<unsigned> &_hashes) : hashes(_hashes) {}
+
+  bool operator()(unsigned a, unsigned b) const {
+    return hashes[a] < hashes[b];
+  }
+};
+
+/// CanonicalizingSolver - Rewrite every query into a canonical form before
+/// forwarding it: constraints are sorted by a hash independent of array
+/// identity, and symbolic arrays are renamed in order of first use.
+///
+/// Queries from different states which only differ in the names of their
+/// symbolic objects (e.g. "arg0" vs. "arg0_1", as made unique by
+/// executeMakeSymbolic) become identical, so the caches below this solver
+/// can share their entries.
+class CanonicalizingSolver : public SolverImpl {
+private:
+  Solver *solver;
+  ArrayCache arrayCache;
+
+  struct CanonicalQuery {
+    ConstraintManager constraints;
+    ref<Expr> expr;
+
+    Query getQuery() const { return Query(constraints, expr); }
+  };
+
+  void canonicalize(const Query &query, CanonicalQuery &result,
+                    ArrayRenamer &renamer);
+
+public:
+  CanonicalizingSolver(Solver *s) : solver(s) {}
+  ~CanonicalizingSolver() { delete solver; }
+
+  bool computeValidity(const Query&, Solver::Validity &result);
+  bool computeTruth(const Query&, bool &isValid);
+  bool computeValue(const Query&, ref<Expr> &result);
+  bool computeInitialValues(const Query& query,
+                            const std::vector<const Array*> &objects,
+                            std::vector< std::vector<unsigned char> > &values,
+                            bool &hasSolution);
+  SolverRunStatus getOperationStatusCode();
+  char *getConstraintLog(const Query&);
+  void setCoreSolverTimeout(double timeout);
+};
+
+void CanonicalizingSolver::canonicalize(const Query &query,
+                                        CanonicalQuery &result,
+                                        ArrayRenamer &renamer) {
+  std::vector< ref<Expr> > constraints(query.constraints.begin(),
+                                       query.constraints.end());
+
+  // Order the constraints by shape (stable, so constraints with the same
+  // shape keep their relative order).
+  ShapeHasher hasher;
+  std::vector<unsigned> hashes, order;
+  hashes.reserve(constraints.size());
+  order.reserve(constraints.size());
+  for (unsigned i = 0; i != constraints.size(); ++i) {
+    hashes.push_back(hasher.hash(constraints[i]));
+    order.push_back(i);
+  }
+  std::stable_sort(order.begin(), order.end(), ShapeOrder(hashes));
+
+  std::vector< ref<Expr> > renamed;
+  renamed.reserve(constraints.size());
+  for (unsigned i = 0; i != order.size(); ++i)
+    renamed.push_back(renamer.visit(constraints[order[i]]));
+
+  result.constraints = ConstraintManager(renamed);
+  result.expr = renamer.visit(query.expr);
+}
+
+bool CanonicalizingSolver::computeValidity(const Query& query,
+                                           Solver::Validity &result) {
+  ArrayRenamer renamer(arrayCache);
+  CanonicalQuery canonical;
+  canonicalize(query, canonical, renamer);
+  return solver->impl->computeValidity(canonical.getQuery(), result);
+}
+
+bool CanonicalizingSolver::computeTruth(const Query& query, bool &isValid) {
+  ArrayRenamer renamer(arrayCache);
+  CanonicalQuery canonical;
+  canonicalize(query, canonical, renamer);
+  return solver->impl->computeTruth(canonical.getQuery(), isValid);
+}
+
+bool CanonicalizingSolver::computeValue(const Query& query,
+                                        ref<Expr> &result) {
+  ArrayRenamer renamer(arrayCache);
+  CanonicalQuery canonical;
+  canonicalize(query, canonical, renamer);
+  return solver->impl->computeValue(canonical.getQuery(), result);
+}
+
+bool
+CanonicalizingSolver::computeInitialValues(const Query& query,
+                                           const std::vector<const Array*>
+                                             &objects,
+                                           std::vector< std::vector<unsigned char> >
+                                             &values,
+                                           bool &hasSolution) {
+  ArrayRenamer renamer(arrayCache);
+  CanonicalQuery canonical;
+  canonicalize(query, canonical, renamer);
+
+  // Objects not mentioned by the query are numbered after the others. The
+  // values only depend on the order of the objects, so they are returned
+  // as is.
+  std::vector<const Array*> canonicalObjects;
+  canonicalObjects.reserve(objects.size());
+  for (unsigned i = 0; i != objects.size(); ++i)
+    canonicalObjects.push_back(renamer.getCanonicalArray(objects[i]));
+
+  return solver->impl->computeInitialValues(canonical.getQuery(),
+                                            canonicalObjects, values,
+                                            hasSolution);
+}
+
+SolverImpl::SolverRunStatus CanonicalizingSolver::getOperationStatusCode() {
+  return solver->impl->getOperationStatusCode();
+}
+
+char *CanonicalizingSolver::getConstraintLog(const Query& query) {
+  return solver->impl->getConstraintLog(query);
+}
+
+void CanonicalizingSolver::setCoreSolverTimeout(double timeout) {
+  solver->impl->setCoreSolverTimeout(timeout);
+}
+
+} // End anonymous namespace
+
+///
+
+Solver *klee::createCanonicalizingSolver(Solver *_solver) {
+  return new Solver(new CanonicalizingSolver(_solver));
+}
@@ -0,0 +1,248 @@
+//===-- CoalescingSolver.cpp - Coalescing of repeated queries -------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Solver.h"
+
+#include "klee/Constraints.h"
+#include "klee/Expr.h"
+#include "klee/SolverImpl.h"
+#include "klee/SolverStats.h"
+
+#include <list>
+#include <vector>
+
+using namespace klee;
+
+/// CoalescingSolver - Keep the outcome of the most recent queries of every
+/// kind and answer an identical query from it without going further down
+/// the chain.
+///
+/// Sibling states coming out of the same fork tend to issue the same query
+/// in close succession (for instance the bounds check after a switch). Their
+/// constraints differ in the branch condition of the fork, so the solver is
+/// placed below the IndependentSolver, which leaves that condition out of
+/// queries on unrelated variables. Unlike the CachingSolver, this also
+/// covers getValue/getInitialValues queries and failed queries: when a query
+/// timed out, an identical query made under the same timeout is answered
+/// with the same failure instead of timing out again.
+class CoalescingSolver : public SolverImpl {
+private:
+  enum QueryKind { Validity, Truth, Value, InitialValues };
+
+  struct Entry {
+    QueryKind kind;
+    unsigned hash;
+    double timeout;
+    std::vector< ref<Expr> > constraints;
+    ref<Expr> expr;
+    std::vector<const Array*> objects;
+
+    /// The outcome of the query.
+    bool success;
+    SolverRunStatus status;
+    Solver::Validity validity;
+    bool isValid;
+    ref<Expr> value;
+    std::vector< std::vector<unsigned char> > values;
+    bool hasSolution;
+  };
+
+  /// Recent queries, most recent first.
+  std::list<Entry> window;
+
+  Solver *solver;
+  double timeout;
+  SolverRunStatus lastStatus;
+
+  static const unsigned WindowSize = 64;
+
+  static unsigned hashQuery(QueryKind kind, const Query &query,
+                            const std::vector<const Array*> *objects);
+
+  Entry *lookup(QueryKind kind, const Query &query,
+                const std::vector<const Array*> *objects = 0);
+  Entry &insert(QueryKind kind, const Query &query, bool success,
+                const std::vector<const Array*> *objects = 0);
+
+public:
+  CoalescingSolver(Solver *s)
+    : solver(s), timeout(0), lastStatus(SOLVER_RUN_STATUS_FAILURE) {}
+  ~CoalescingSolver() { delete solver; }
+
+  bool computeValidity(const Query&, Solver::Validity &result);
+  bool computeTruth(const Query&, bool &isValid);
+  bool computeValue(const Query&, ref<Expr> &result);
+  bool computeInitialValues(const Query& query,
+                            const std::vector<const Array*> &objects,
+                            std::vector< std::vector<unsigned char> > &values,
+                            bool &hasSolution);
+  SolverRunStatus getOperationStatusCode();
+  char *getConstraintLog(const Query&);
+  void setCoreSolverTimeout(double timeout);
+};
+
+unsigned CoalescingSolver::hashQuery(QueryKind kind, const Query &query,
+                                     const std::vector<const Array*>
+                                       *objects) {
+  unsigned result = query.expr->hash() * Expr::MAGIC_HASH_CONSTANT + kind;
+  for (ConstraintManager::const_iterator it = query.constraints.begin(),
+         ie = query.constraints.end(); it != ie; ++it)
+    result = result * Expr::MAGIC_HASH_CONSTANT + (*it)->hash();
+  if (objects)
+    for (unsigned i = 0; i != objects->size(); ++i)
+      result = result * Expr::MAGIC_HASH_CONSTANT +
+        (unsigned) (unsigned long) (*objects)[i];
+  return result;
+}
+
+CoalescingSolver::Entry *
+CoalescingSolver::lookup(QueryKind kind, const Query &query,
+                         const std::vector<const Array*> *objects) {
+  unsigned hash = hashQuery(kind, query, objects);
+
+  for (std::list<Entry>::iterator it = window.begin(), ie = window.end();
+       it != ie; ++it) {
+    if (it->hash != hash || it->kind != kind ||
+        it->constraints.size() != query.constraints.size())
+      continue;
+
+    // A failed query is only known to fail again under the same timeout.
+    if (!it->success && it->timeout != timeout)
+      continue;
+    if (*it->expr.get() != *query.expr.get())
+      continue;
+    if (objects && it->objects != *objects)
+      continue;
+
+    bool same = true;
+    std::vector< ref<Expr> >::const_iterator cit = it->constraints.begin();
+    for (ConstraintManager::const_iterator qit = query.constraints.begin(),
+           qie = query.constraints.end(); qit != qie; ++qit, ++cit) {
+      if (*cit != *qit) {
+        same = false;
+        break;
+      }
+    }
+    if (!same)
+      continue;
+
+    // Move to the front, so the window behaves as an LRU list.
+    window.splice(window.begin(), window, it);
+    lastStatus = window.front().status;
+    ++stats::queryCoalesced;
+    return &window.front();
+  }
+
+  return 0;
+}
+
+CoalescingSolver::Entry &
+CoalescingSolver::insert(QueryKind kind, const Query &query, bool success,
+                         const std::vector<const Array*> *objects) {
+  if (window.size() >= WindowSize)
+    window.pop_back();
+  window.push_front(Entry());
+
+  Entry &entry = window.front();
+  entry.kind = kind;
+  entry.hash = hashQuery(kind, query, objects);
+  entry.timeout = timeout;
+  entry.constraints.assign(query.constraints.begin(),
+                           query.constraints.end());
+  entry.expr = query.expr;
+  if (objects)
+    entry.objects = *objects;
+  entry.success = success;
+  entry.status = lastStatus = solver->impl->getOperationStatusCode();
+  entry.validity = Solver::Unknown;
+  entry.isValid = false;
+  entry.hasSolution = false;
+  return entry;
+}
+
+bool CoalescingSolver::computeValidity(const Query& query,
+                                       Solver::Validity &result) {
+  if (Entry *entry = lookup(Validity, query)) {
+    result = entry->validity;
+    return entry->success;
+  }
+
+  bool success = solver->impl->computeValidity(query, result);
+  insert(Validity, query, success).validity = result;
+  return success;
+}
+
+bool CoalescingSolver::computeTruth(const Query& query, bool &isValid) {
+  if (Entry *entry = lookup(Truth, query)) {
+    isValid = entry->isValid;
+    return entry->success;
+  }
+
+  bool success = solver->impl->computeTruth(query, isValid);
+  insert(Truth, query, success).isValid = isValid;
+  return success;
+}
+
+bool CoalescingSolver::computeValue(const Query& query, ref<Expr> &result) {
+  if (Entry *entry = lookup(Value, query)) {
+    if (entry->success)
+      result = entry->value;
+    return entry->success;
+  }
+
+  bool success = solver->impl->computeValue(query, result);
+  Entry &entry = insert(Value, query, success);
+  if (success)
+    entry.value = result;
+  return success;
+}
+
+bool
+CoalescingSolver::computeInitialValues(const Query& query,
+                                       const std::vector<const Array*>
+                                         &objects,
+                                       std::vector< std::vector<unsigned char> >
+                                         &values,
+                                       bool &hasSolution) {
+  if (Entry *entry = lookup(InitialValues, query, &objects)) {
+    if (entry->success) {
+      hasSolution = entry->hasSolution;
+      values = entry->values;
+    }
+    return entry->success;
+  }
+
+  bool success = solver->impl->computeInitialValues(query, objects, values,
+                                                    hasSolution);
+  Entry &entry = insert(InitialValues, query, success, &objects);
+  if (success) {
+    entry.hasSolution = hasSolution;
+    entry.values = values;
+  }
+  return success;
+}
+
+SolverImpl::SolverRunStatus CoalescingSolver::getOperationStatusCode() {
+  return lastStatus;
+}
+
+char *CoalescingSolver::getConstraintLog(const Query& query) {
+  return solver->impl->getConstraintLog(query);
+}
+
+void CoalescingSolver::setCoreSolverTimeout(double _timeout) {
+  timeout = _timeout;
+  solver->impl->setCoreSolverTimeout(_timeout);
+}
+
+///
+
+Solver *klee::createCoalescingSolver(Solver *_solver) {
+  return new Solver(new CoalescingSolver(_solver));
+}
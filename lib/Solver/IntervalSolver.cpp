@@ -0,0 +1,1102 @@
+//===-- IntervalSolver.cpp ------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Solver.h"
+
+#include "klee/Constraints.h"
+#include "klee/Expr.h"
+#include "klee/IncompleteSolver.h"
+#include "klee/SolverStats.h"
+#include "klee/util/Assignment.h"
+#include "klee/util/Bits.h"
+#include "klee/util/ExprHashMap.h"
+#include "klee/Internal/Support/IntEvaluation.h"
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+/// Maximum number of constraint sets whose abstract domain is kept around
+/// for incremental reuse. Queries for a state almost always extend the
+/// constraint set of the previous query for the same state, so a small
+/// number of entries covers the states that are active at any one time.
+const unsigned MaxCachedDomains = 32;
+
+/// ByteDomain - The abstract value of a single symbolic byte: an unsigned
+/// interval together with the bits that are known to be zero or one.
+struct ByteDomain {
+  unsigned char lo, hi, zeros, ones;
+
+  ByteDomain() : lo(0), hi(255), zeros(0), ones(0) {}
+
+  bool matches(unsigned v) const {
+    return (v & zeros) == 0 && (v & ones) == ones;
+  }
+
+  /// normalize - Tighten the bounds to the values consistent with the known
+  /// bits (and vice versa).
+  ///
+  /// \return False if no value remains.
+  bool normalize() {
+    if (zeros & ones)
+      return false;
+
+    int l = lo, h = hi;
+    while (l <= h && !matches(l)) ++l;
+    while (h >= l && !matches(h)) --h;
+    if (l > h)
+      return false;
+    lo = l;
+    hi = h;
+
+    // All bits above the highest bit in which the bounds differ are fixed.
+    unsigned diff = lo ^ hi, prefix = 0xFF;
+    while (diff) {
+      diff >>= 1;
+      prefix = (prefix << 1) & 0xFF;
+    }
+    ones |= lo & prefix;
+    zeros |= ~lo & prefix;
+    return true;
+  }
+};
+
+/// IntervalDomain - An abstract environment mapping each byte of each
+/// symbolic array to a ByteDomain. Bytes with no entry are unconstrained.
+struct IntervalDomain {
+  typedef std::map<const Array*, std::vector<ByteDomain> > bytes_ty;
+
+  bytes_ty bytes;
+
+  /// The constraints were found to be unsatisfiable.
+  bool infeasible;
+
+  IntervalDomain() : infeasible(false) {}
+
+  ByteDomain get(const Array *array, unsigned index) const {
+    bytes_ty::const_iterator it = bytes.find(array);
+    if (it == bytes.end())
+      return ByteDomain();
+    return it->second[index];
+  }
+
+  ByteDomain &getWriteable(const Array *array, unsigned index) {
+    std::vector<ByteDomain> &v = bytes[array];
+    if (v.empty())
+      v.resize(array->size);
+    return v[index];
+  }
+};
+
+/// AbstractValue - The abstract value of an expression of at most 64 bits:
+/// an unsigned interval together with the bits known to be zero or one.
+/// Wider expressions are represented by the top element.
+struct AbstractValue {
+  uint64_t lo, hi, zeros, ones;
+  bool top;
+
+  AbstractValue() : lo(0), hi(0), zeros(0), ones(0), top(true) {}
+  AbstractValue(uint64_t _lo, uint64_t _hi, uint64_t _zeros, uint64_t _ones)
+    : lo(_lo), hi(_hi), zeros(_zeros), ones(_ones), top(false) {}
+
+  static AbstractValue constant(uint64_t value, Expr::Width w) {
+    return AbstractValue(value, value, ~value & bits64::maxValueOfNBits(w),
+                         value);
+  }
+
+  static AbstractValue full(Expr::Width w) {
+    if (w > 64)
+      return AbstractValue();
+    return AbstractValue(0, bits64::maxValueOfNBits(w), 0, 0);
+  }
+
+  static AbstractValue range(uint64_t lo, uint64_t hi, Expr::Width w) {
+    AbstractValue res(lo, hi, 0, 0);
+    res.normalize(w);
+    return res;
+  }
+
+  bool isFixed() const { return !top && lo == hi; }
+
+  /// normalize - Propagate information between the interval and the known
+  /// bits. An empty value can only arise on an infeasible path, and is
+  /// conservatively widened to the full range.
+  void normalize(Expr::Width w) {
+    if (top)
+      return;
+    uint64_t mask = bits64::maxValueOfNBits(w);
+    zeros &= mask;
+    ones &= mask;
+    lo = std::max(lo, ones);
+    hi = std::min(hi, ~zeros & mask);
+    if ((zeros & ones) || lo > hi) {
+      *this = full(w);
+      return;
+    }
+
+    uint64_t diff = lo ^ hi, prefix = mask;
+    while (diff) {
+      diff >>= 1;
+      prefix = (prefix << 1) & mask;
+    }
+    ones |= lo & prefix;
+    zeros |= ~lo & prefix;
+  }
+
+  AbstractValue join(const AbstractValue &b) const {
+    if (top || b.top)
+      return AbstractValue();
+    return AbstractValue(std::min(lo, b.lo), std::max(hi, b.hi),
+                         zeros & b.zeros, ones & b.ones);
+  }
+};
+
+/// ByteView - A view of an expression as a (possibly zero extended)
+/// concatenation of unmodified symbolic bytes, most significant first.
+typedef std::vector<std::pair<const Array*, unsigned> > ByteView;
+
+static bool getByteView(const ref<Expr> &e, ByteView &view) {
+  switch (e->getKind()) {
+  case Expr::Read: {
+    const ReadExpr *re = cast<ReadExpr>(e);
+    const Array *array = re->updates.root;
+    if (re->updates.head || !array->isSymbolicArray() ||
+        re->getWidth() != Expr::Int8)
+      return false;
+    const ConstantExpr *index = dyn_cast<ConstantExpr>(re->index);
+    if (!index || index->getWidth() > 64 ||
+        index->getZExtValue() >= array->size)
+      return false;
+    view.push_back(std::make_pair(array, (unsigned) index->getZExtValue()));
+    return true;
+  }
+  case Expr::Concat: {
+    const ConcatExpr *ce = cast<ConcatExpr>(e);
+    return getByteView(ce->getLeft(), view) &&
+      getByteView(ce->getRight(), view);
+  }
+  default:
+    return false;
+  }
+}
+
+/// IntervalEvaluator - Compute the AbstractValue of an expression under an
+/// IntervalDomain.
+class IntervalEvaluator {
+  const IntervalDomain &domain;
+  ExprHashMap<AbstractValue> cache;
+
+  AbstractValue evalRead(const ReadExpr *re);
+  AbstractValue evalCompare(const ref<Expr> &e);
+  AbstractValue evalUncached(const ref<Expr> &e);
+
+public:
+  IntervalEvaluator(const IntervalDomain &_domain) : domain(_domain) {}
+
+  AbstractValue evaluate(const ref<Expr> &e);
+};
+
+AbstractValue IntervalEvaluator::evaluate(const ref<Expr> &e) {
+  if (ConstantExpr *CE = dyn_cast<ConstantExpr>(e)) {
+    if (CE->getWidth() > 64)
+      return AbstractValue();
+    return AbstractValue::constant(CE->getZExtValue(), CE->getWidth());
+  }
+
+  ExprHashMap<AbstractValue>::iterator it = cache.find(e);
+  if (it != cache.end())
+    return it->second;
+
+  AbstractValue res = evalUncached(e);
+  res.normalize(e->getWidth());
+  cache.insert(std::make_pair(e, res));
+  return res;
+}
+
+AbstractValue IntervalEvaluator::evalRead(const ReadExpr *re) {
+  const Array *array = re->updates.root;
+  AbstractValue index = evaluate(re->index);
+  AbstractValue res;
+  bool haveValue = false;
+
+  // Writes which may alias the read contribute their value. A write to the
+  // exact index shadows everything below it.
+  for (const UpdateNode *un = re->updates.head; un; un = un->next) {
+    AbstractValue ui = evaluate(un->index);
+    if (index.isFixed() && ui.isFixed() && ui.lo != index.lo)
+      continue;
+    if (!index.top && !ui.top && (ui.hi < index.lo || ui.lo > index.hi))
+      continue;
+    AbstractValue v = evaluate(un->value);
+    res = haveValue ? res.join(v) : v;
+    haveValue = true;
+    if (index.isFixed() && ui.isFixed())
+      return res;
+  }
+
+  AbstractValue initial = AbstractValue::full(Expr::Int8);
+  if (!index.top && index.lo < array->size) {
+    uint64_t last = std::min(index.hi, (uint64_t) array->size - 1);
+    if (array->isConstantArray()) {
+      if (last - index.lo < 256) {
+        initial = AbstractValue::constant(
+            array->constantValues[index.lo]->getZExtValue(8), Expr::Int8);
+        for (uint64_t i = index.lo + 1; i <= last; ++i)
+          initial = initial.join(AbstractValue::constant(
+              array->constantValues[i]->getZExtValue(8), Expr::Int8));
+      }
+    } else if (index.isFixed()) {
+      ByteDomain bd = domain.get(array, index.lo);
+      initial = AbstractValue(bd.lo, bd.hi, bd.zeros, bd.ones);
+    }
+  }
+
+  return haveValue ? res.join(initial) : initial;
+}
+
+AbstractValue IntervalEvaluator::evalCompare(const ref<Expr> &e) {
+  const CmpExpr *ce = cast<CmpExpr>(e);
+  Expr::Width w = ce->left->getWidth();
+  AbstractValue l = evaluate(ce->left), r = evaluate(ce->right);
+  AbstractValue unknown = AbstractValue::full(Expr::Bool);
+  if (l.top || r.top)
+    return unknown;
+
+  // Signed comparisons are decided on the signed bounds, which are only
+  // meaningful when a range does not straddle the sign boundary.
+  uint64_t signBit = (uint64_t) 1 << (w - 1);
+  bool lSplit = (l.lo < signBit) != (l.hi < signBit);
+  bool rSplit = (r.lo < signBit) != (r.hi < signBit);
+  int64_t slo = 0, shi = 0, srlo = 0, srhi = 0;
+  if (!lSplit && !rSplit) {
+    slo = ints::sext(l.lo, 64, w);
+    shi = ints::sext(l.hi, 64, w);
+    srlo = ints::sext(r.lo, 64, w);
+    srhi = ints::sext(r.hi, 64, w);
+  }
+
+  switch (e->getKind()) {
+  case Expr::Eq:
+    if (l.isFixed() && r.isFixed() && l.lo == r.lo)
+      return AbstractValue::constant(1, Expr::Bool);
+    if (l.hi < r.lo || l.lo > r.hi ||
+        (l.ones & r.zeros) || (l.zeros & r.ones))
+      return AbstractValue::constant(0, Expr::Bool);
+    return unknown;
+  case Expr::Ult:
+    if (l.hi < r.lo) return AbstractValue::constant(1, Expr::Bool);
+    if (l.lo >= r.hi) return AbstractValue::constant(0, Expr::Bool);
+    return unknown;
+  case Expr::Ule:
+    if (l.hi <= r.lo) return AbstractValue::constant(1, Expr::Bool);
+    if (l.lo > r.hi) return AbstractValue::constant(0, Expr::Bool);
+    return unknown;
+  case Expr::Slt:
+    if (lSplit || rSplit) return unknown;
+    if (shi < srlo) return AbstractValue::constant(1, Expr::Bool);
+    if (slo >= srhi) return AbstractValue::constant(0, Expr::Bool);
+    return unknown;
+  case Expr::Sle:
+    if (lSplit || rSplit) return unknown;
+    if (shi <= srlo) return AbstractValue::constant(1, Expr::Bool);
+    if (slo > srhi) return AbstractValue::constant(0, Expr::Bool);
+    return unknown;
+  default:
+    // Ne, Ugt, Uge, Sgt and Sge are canonicalized away.
+    return unknown;
+  }
+}
+
+AbstractValue IntervalEvaluator::evalUncached(const ref<Expr> &e) {
+  Expr::Width w = e->getWidth();
+  if (w > 64)
+    return AbstractValue();
+  uint64_t mask = bits64::maxValueOfNBits(w);
+  AbstractValue full = AbstractValue::full(w);
+
+  switch (e->getKind()) {
+  case Expr::NotOptimized:
+    return evaluate(cast<NotOptimizedExpr>(e)->src);
+
+  case Expr::Read:
+    return evalRead(cast<ReadExpr>(e));
+
+  case Expr::Select: {
+    const SelectExpr *se = cast<SelectExpr>(e);
+    AbstractValue cond = evaluate(se->cond);
+    if (cond.isFixed())
+      return evaluate(cond.lo ? se->trueExpr : se->falseExpr);
+    return evaluate(se->trueExpr).join(evaluate(se->falseExpr));
+  }
+
+  case Expr::Concat: {
+    const ConcatExpr *ce = cast<ConcatExpr>(e);
+    AbstractValue l = evaluate(ce->getLeft()), r = evaluate(ce->getRight());
+    if (l.top || r.top)
+      return full;
+    unsigned shift = ce->getRight()->getWidth();
+    return AbstractValue((l.lo << shift) | r.lo, (l.hi << shift) | r.hi,
+                         (l.zeros << shift) | r.zeros,
+                         (l.ones << shift) | r.ones);
+  }
+
+  case Expr::Extract: {
+    const ExtractExpr *ee = cast<ExtractExpr>(e);
+    AbstractValue v = evaluate(ee->expr);
+    if (v.top)
+      return full;
+    AbstractValue res(0, mask, (v.zeros >> ee->offset) & mask,
+                      (v.ones >> ee->offset) & mask);
+    if ((v.hi >> ee->offset) <= mask) {
+      res.lo = v.lo >> ee->offset;
+      res.hi = v.hi >> ee->offset;
+    }
+    return res;
+  }
+
+  case Expr::ZExt: {
+    const CastExpr *ce = cast<CastExpr>(e);
+    AbstractValue v = evaluate(ce->src);
+    if (v.top)
+      return full;
+    v.zeros |= mask & ~bits64::maxValueOfNBits(ce->src->getWidth());
+    return v;
+  }
+
+  case Expr::SExt: {
+    const CastExpr *ce = cast<CastExpr>(e);
+    Expr::Width sw = ce->src->getWidth();
+    AbstractValue v = evaluate(ce->src);
+    if (v.top)
+      return full;
+    uint64_t ext = mask & ~bits64::maxValueOfNBits(sw);
+    uint64_t signBit = (uint64_t) 1 << (sw - 1);
+    if (v.hi < signBit) {
+      v.zeros |= ext;
+      return v;
+    }
+    if (v.lo >= signBit)
+      return AbstractValue(v.lo | ext, v.hi | ext, v.zeros, v.ones | ext);
+    return full;
+  }
+
+  case Expr::Add: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    AbstractValue l = evaluate(be->left), r = evaluate(be->right);
+    if (l.top || r.top)
+      return full;
+    if (l.hi <= mask - r.hi)
+      return AbstractValue(l.lo + r.lo, l.hi + r.hi, 0, 0);
+    if (l.lo > mask - r.lo) // both bounds wrap exactly once
+      return AbstractValue((l.lo + r.lo) & mask, (l.hi + r.hi) & mask, 0, 0);
+    return full;
+  }
+
+  case Expr::Sub: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    AbstractValue l = evaluate(be->left), r = evaluate(be->right);
+    if (l.top || r.top)
+      return full;
+    if (l.lo >= r.hi)
+      return AbstractValue(l.lo - r.hi, l.hi - r.lo, 0, 0);
+    if (l.hi < r.lo)
+      return AbstractValue((l.lo - r.hi) & mask, (l.hi - r.lo) & mask, 0, 0);
+    return full;
+  }
+
+  case Expr::Mul: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    AbstractValue l = evaluate(be->left), r = evaluate(be->right);
+    if (l.top || r.top)
+      return full;
+    if (r.hi == 0 || l.hi <= mask / r.hi)
+      return AbstractValue(l.lo * r.lo, l.hi * r.hi, 0, 0);
+    return full;
+  }
+
+  case Expr::UDiv: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    AbstractValue l = evaluate(be->left), r = evaluate(be->right);
+    if (l.top || r.top || r.lo == 0)
+      return full;
+    return AbstractValue(l.lo / r.hi, l.hi / r.lo, 0, 0);
+  }
+
+  case Expr::URem: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    AbstractValue l = evaluate(be->left), r = evaluate(be->right);
+    if (l.top || r.top || r.lo == 0)
+      return full;
+    if (l.hi < r.lo)
+      return l;
+    return AbstractValue(0, std::min(l.hi, r.hi - 1), 0, 0);
+  }
+
+  case Expr::And: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    AbstractValue l = evaluate(be->left), r = evaluate(be->right);
+    if (l.top || r.top)
+      return full;
+    return AbstractValue(0, std::min(l.hi, r.hi),
+                         l.zeros | r.zeros, l.ones & r.ones);
+  }
+
+  case Expr::Or: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    AbstractValue l = evaluate(be->left), r = evaluate(be->right);
+    if (l.top || r.top)
+      return full;
+    return AbstractValue(std::max(l.lo, r.lo), mask,
+                         l.zeros & r.zeros, l.ones | r.ones);
+  }
+
+  case Expr::Xor: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    AbstractValue l = evaluate(be->left), r = evaluate(be->right);
+    if (l.top || r.top)
+      return full;
+    uint64_t known = (l.zeros | l.ones) & (r.zeros | r.ones);
+    uint64_t value = (l.ones ^ r.ones) & known;
+    return AbstractValue(0, mask, known & ~value, value);
+  }
+
+  case Expr::Not: {
+    AbstractValue v = evaluate(cast<NotExpr>(e)->expr);
+    if (v.top)
+      return full;
+    return AbstractValue(~v.hi & mask, ~v.lo & mask, v.ones, v.zeros);
+  }
+
+  case Expr::Shl:
+  case Expr::LShr:
+  case Expr::AShr: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    AbstractValue l = evaluate(be->left), r = evaluate(be->right);
+    if (l.top || !r.isFixed() || r.lo >= w)
+      return full;
+    unsigned shift = r.lo;
+    uint64_t signBit = (uint64_t) 1 << (w - 1);
+    if (e->getKind() == Expr::Shl) {
+      uint64_t shiftedIn = bits64::maxValueOfNBits(shift);
+      if ((l.hi << shift) >> shift == l.hi && (l.hi << shift) <= mask)
+        return AbstractValue(l.lo << shift, l.hi << shift,
+                             ((l.zeros << shift) | shiftedIn) & mask,
+                             (l.ones << shift) & mask);
+      return AbstractValue(0, mask, ((l.zeros << shift) | shiftedIn) & mask,
+                           (l.ones << shift) & mask);
+    }
+    if (e->getKind() == Expr::AShr && l.hi >= signBit)
+      return full;
+    uint64_t shiftedIn = mask & ~(mask >> shift);
+    return AbstractValue(l.lo >> shift, l.hi >> shift,
+                         (l.zeros >> shift) | shiftedIn, l.ones >> shift);
+  }
+
+  case Expr::Eq:
+  case Expr::Ult:
+  case Expr::Ule:
+  case Expr::Slt:
+  case Expr::Sle:
+    return evalCompare(e);
+
+  default:
+    return full;
+  }
+}
+
+/// IntervalPropagator - Refine an IntervalDomain with the information
+/// implied by a constraint being true (or false).
+class IntervalPropagator {
+  IntervalDomain &domain;
+
+  AbstractValue evaluate(const ref<Expr> &e) {
+    IntervalEvaluator evaluator(domain);
+    return evaluator.evaluate(e);
+  }
+
+  void constrainByte(const Array *array, unsigned index,
+                     unsigned lo, unsigned hi,
+                     unsigned zeros, unsigned ones) {
+    ByteDomain &bd = domain.getWriteable(array, index);
+    bd.lo = std::max((unsigned) bd.lo, lo);
+    bd.hi = std::min((unsigned) bd.hi, hi);
+    bd.zeros |= zeros;
+    bd.ones |= ones;
+    if (bd.lo > bd.hi || !bd.normalize())
+      domain.infeasible = true;
+  }
+
+  void constrainViewUpper(const ByteView &view, uint64_t bound);
+  void constrainViewLower(const ByteView &view, uint64_t bound);
+  void constrainViewBits(const ByteView &view, uint64_t zeros, uint64_t ones);
+
+  void constrainRange(const ref<Expr> &e, uint64_t lo, uint64_t hi);
+  void constrainBits(const ref<Expr> &e, uint64_t zeros, uint64_t ones);
+  void constrainEquality(const ref<Expr> &l, const ref<Expr> &r, bool truth);
+  void constrainCompare(const ref<Expr> &l, const ref<Expr> &r,
+                        bool strict, bool isSigned);
+
+public:
+  IntervalPropagator(IntervalDomain &_domain) : domain(_domain) {}
+
+  void constrain(const ref<Expr> &e, bool truth);
+};
+
+void IntervalPropagator::constrainViewUpper(const ByteView &view,
+                                            uint64_t bound) {
+  // value <= bound: the most significant byte is bounded by the top byte of
+  // the bound; the next byte is only bounded once the top one is pinned.
+  for (unsigned i = 0, n = view.size(); i != n && !domain.infeasible; ++i) {
+    unsigned b = (bound >> (8 * (n - 1 - i))) & 0xFF;
+    constrainByte(view[i].first, view[i].second, 0, b, 0, 0);
+    ByteDomain bd = domain.get(view[i].first, view[i].second);
+    if (bd.lo != b)
+      break;
+  }
+}
+
+void IntervalPropagator::constrainViewLower(const ByteView &view,
+                                            uint64_t bound) {
+  for (unsigned i = 0, n = view.size(); i != n && !domain.infeasible; ++i) {
+    unsigned b = (bound >> (8 * (n - 1 - i))) & 0xFF;
+    constrainByte(view[i].first, view[i].second, b, 255, 0, 0);
+    ByteDomain bd = domain.get(view[i].first, view[i].second);
+    if (bd.hi != b)
+      break;
+  }
+}
+
+void IntervalPropagator::constrainViewBits(const ByteView &view,
+                                           uint64_t zeros, uint64_t ones) {
+  for (unsigned i = 0, n = view.size(); i != n && !domain.infeasible; ++i) {
+    unsigned shift = 8 * (n - 1 - i);
+    constrainByte(view[i].first, view[i].second, 0, 255,
+                  (zeros >> shift) & 0xFF, (ones >> shift) & 0xFF);
+  }
+}
+
+/// constrainRange - Refine the domain with lo <= e <= hi (unsigned).
+void IntervalPropagator::constrainRange(const ref<Expr> &e,
+                                        uint64_t lo, uint64_t hi) {
+  Expr::Width w = e->getWidth();
+  if (w > 64 || domain.infeasible)
+    return;
+  if (lo > hi) {
+    domain.infeasible = true;
+    return;
+  }
+
+  switch (e->getKind()) {
+  case Expr::Read:
+  case Expr::Concat: {
+    ByteView view;
+    if (!getByteView(e, view) || view.size() > 8)
+      return;
+    constrainViewLower(view, lo);
+    constrainViewUpper(view, hi);
+    return;
+  }
+
+  case Expr::ZExt: {
+    const CastExpr *ce = cast<CastExpr>(e);
+    uint64_t srcMax = bits64::maxValueOfNBits(ce->src->getWidth());
+    if (lo > srcMax) {
+      domain.infeasible = true;
+      return;
+    }
+    constrainRange(ce->src, lo, std::min(hi, srcMax));
+    return;
+  }
+
+  case Expr::Add: {
+    // k + x in [lo, hi] ==> x in [lo - k, hi - k], if that does not wrap.
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    const ConstantExpr *k = dyn_cast<ConstantExpr>(be->left);
+    if (!k)
+      return;
+    uint64_t mask = bits64::maxValueOfNBits(w);
+    uint64_t nlo = (lo - k->getZExtValue()) & mask;
+    uint64_t nhi = (hi - k->getZExtValue()) & mask;
+    if (nlo <= nhi)
+      constrainRange(be->right, nlo, nhi);
+    return;
+  }
+
+  default:
+    return;
+  }
+}
+
+/// constrainBits - Refine the domain with the given known bits of e.
+void IntervalPropagator::constrainBits(const ref<Expr> &e,
+                                       uint64_t zeros, uint64_t ones) {
+  Expr::Width w = e->getWidth();
+  if (w > 64 || domain.infeasible)
+    return;
+
+  switch (e->getKind()) {
+  case Expr::Read:
+  case Expr::Concat: {
+    ByteView view;
+    if (getByteView(e, view) && view.size() <= 8)
+      constrainViewBits(view, zeros, ones);
+    return;
+  }
+
+  case Expr::ZExt: {
+    const CastExpr *ce = cast<CastExpr>(e);
+    uint64_t srcMask = bits64::maxValueOfNBits(ce->src->getWidth());
+    if (ones & ~srcMask) {
+      domain.infeasible = true;
+      return;
+    }
+    constrainBits(ce->src, zeros & srcMask, ones);
+    return;
+  }
+
+  case Expr::Extract: {
+    const ExtractExpr *ee = cast<ExtractExpr>(e);
+    if (ee->expr->getWidth() <= 64)
+      constrainBits(ee->expr, zeros << ee->offset, ones << ee->offset);
+    return;
+  }
+
+  default:
+    return;
+  }
+}
+
+void IntervalPropagator::constrainEquality(const ref<Expr> &l,
+                                           const ref<Expr> &r, bool truth) {
+  // Canonical form puts constants on the left.
+  const ConstantExpr *CE = dyn_cast<ConstantExpr>(l);
+  if (!CE || CE->getWidth() > 64)
+    return;
+  uint64_t value = CE->getZExtValue();
+  Expr::Width w = r->getWidth();
+  uint64_t mask = bits64::maxValueOfNBits(w);
+
+  if (w == Expr::Bool) {
+    constrain(r, truth ? value : !value);
+    return;
+  }
+
+  if (truth) {
+    constrainRange(r, value, value);
+    constrainBits(r, ~value & mask, value);
+
+    // c == (m & x) fixes the bits of x selected by m.
+    if (const AndExpr *ae = dyn_cast<AndExpr>(r))
+      if (const ConstantExpr *m = dyn_cast<ConstantExpr>(ae->left)) {
+        uint64_t bits = m->getZExtValue();
+        if (value & ~bits)
+          domain.infeasible = true;
+        else
+          constrainBits(ae->right, bits & ~value, value);
+      }
+    return;
+  }
+
+  // x != c can shave an endpoint off the range of x.
+  AbstractValue v = evaluate(r);
+  if (v.top)
+    return;
+  if (v.isFixed() && v.lo == value) {
+    domain.infeasible = true;
+  } else if (v.lo == value) {
+    constrainRange(r, value + 1, v.hi);
+  } else if (v.hi == value) {
+    constrainRange(r, v.lo, value - 1);
+  }
+
+  // (m & x) != c with a single bit m fixes that bit.
+  if (const AndExpr *ae = dyn_cast<AndExpr>(r))
+    if (const ConstantExpr *m = dyn_cast<ConstantExpr>(ae->left)) {
+      uint64_t bit = m->getZExtValue();
+      if (bits64::isPowerOfTwo(bit) && !(value & ~bit)) {
+        if (value)
+          constrainBits(ae->right, bit, 0);
+        else
+          constrainBits(ae->right, 0, bit);
+      }
+    }
+}
+
+/// constrainCompare - Refine the domain with l < r (strict) or l <= r.
+void IntervalPropagator::constrainCompare(const ref<Expr> &l,
+                                          const ref<Expr> &r,
+                                          bool strict, bool isSigned) {
+  Expr::Width w = l->getWidth();
+  if (w > 64)
+    return;
+  uint64_t mask = bits64::maxValueOfNBits(w);
+  AbstractValue lv = evaluate(l), rv = evaluate(r);
+  if (lv.top || rv.top)
+    return;
+
+  if (isSigned) {
+    // Only handle the case where both sides are known non-negative, in which
+    // the signed and unsigned orders coincide.
+    uint64_t signBit = (uint64_t) 1 << (w - 1);
+    if (lv.hi >= signBit || rv.hi >= signBit)
+      return;
+  }
+
+  // l <= r - strict and r >= l + strict
+  if (strict && rv.hi == 0) {
+    domain.infeasible = true;
+    return;
+  }
+  if (strict && lv.lo == mask) {
+    domain.infeasible = true;
+    return;
+  }
+  uint64_t lMax = rv.hi - (strict ? 1 : 0);
+  uint64_t rMin = lv.lo + (strict ? 1 : 0);
+  if (lv.lo > lMax || rMin > rv.hi) {
+    domain.infeasible = true;
+    return;
+  }
+  if (lMax < lv.hi)
+    constrainRange(l, lv.lo, lMax);
+  if (rMin > rv.lo)
+    constrainRange(r, rMin, rv.hi);
+}
+
+void IntervalPropagator::constrain(const ref<Expr> &e, bool truth) {
+  if (domain.infeasible)
+    return;
+
+  switch (e->getKind()) {
+  case Expr::Constant:
+    if (cast<ConstantExpr>(e)->isTrue() != truth)
+      domain.infeasible = true;
+    return;
+
+  case Expr::NotOptimized:
+    constrain(cast<NotOptimizedExpr>(e)->src, truth);
+    return;
+
+  case Expr::Not:
+    constrain(cast<NotExpr>(e)->expr, !truth);
+    return;
+
+  case Expr::And: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    if (truth) {
+      constrain(be->left, true);
+      constrain(be->right, true);
+    } else {
+      // !(a && b): if one side must hold, the other must not.
+      AbstractValue l = evaluate(be->left), r = evaluate(be->right);
+      if (l.isFixed() && l.lo)
+        constrain(be->right, false);
+      else if (r.isFixed() && r.lo)
+        constrain(be->left, false);
+    }
+    return;
+  }
+
+  case Expr::Or: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    if (!truth) {
+      constrain(be->left, false);
+      constrain(be->right, false);
+    } else {
+      AbstractValue l = evaluate(be->left), r = evaluate(be->right);
+      if (l.isFixed() && !l.lo)
+        constrain(be->right, true);
+      else if (r.isFixed() && !r.lo)
+        constrain(be->left, true);
+    }
+    return;
+  }
+
+  case Expr::Eq: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    constrainEquality(be->left, be->right, truth);
+    return;
+  }
+
+  case Expr::Ult:
+  case Expr::Ule:
+  case Expr::Slt:
+  case Expr::Sle: {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    bool strict = e->getKind() == Expr::Ult || e->getKind() == Expr::Slt;
+    bool isSigned = e->getKind() == Expr::Slt || e->getKind() == Expr::Sle;
+    if (truth)
+      constrainCompare(be->left, be->right, strict, isSigned);
+    else // !(l < r) <==> r <= l, !(l <= r) <==> r < l
+      constrainCompare(be->right, be->left, !strict, isSigned);
+    return;
+  }
+
+  default:
+    return;
+  }
+}
+
+/***/
+
+/// IntervalSolver - An incomplete solver which answers queries using an
+/// abstract domain of intervals and known bits for each symbolic byte.
+///
+/// The domain computed for a constraint set is cached, and a query whose
+/// constraints extend a cached set (the common case, since a state only
+/// ever appends to its constraints) only propagates the new constraints.
+class IntervalSolver : public IncompleteSolver {
+  struct CacheEntry {
+    std::vector< ref<Expr> > constraints;
+    IntervalDomain domain;
+
+    enum { WitnessUnknown, WitnessValid, WitnessInvalid } witnessState;
+    /// An assignment satisfying all the constraints, if witnessState is
+    /// WitnessValid.
+    Assignment witness;
+
+    CacheEntry() : witnessState(WitnessUnknown) {}
+  };
+
+  std::list<CacheEntry*> cache;
+
+  CacheEntry *getEntry(const Query &query);
+  bool getWitness(CacheEntry *entry);
+
+public:
+  IntervalSolver() {}
+  ~IntervalSolver();
+
+  IncompleteSolver::PartialValidity computeValidity(const Query&);
+  IncompleteSolver::PartialValidity computeTruth(const Query&);
+  bool computeValue(const Query&, ref<Expr> &result);
+  bool computeInitialValues(const Query&,
+                            const std::vector<const Array*> &objects,
+                            std::vector< std::vector<unsigned char> > &values,
+                            bool &hasSolution);
+};
+
+IntervalSolver::~IntervalSolver() {
+  for (std::list<CacheEntry*>::iterator it = cache.begin(),
+         ie = cache.end(); it != ie; ++it)
+    delete *it;
+}
+
+/// getEntry - Return the cache entry for the constraints of the query,
+/// computing it from the longest cached prefix if necessary.
+IntervalSolver::CacheEntry *IntervalSolver::getEntry(const Query &query) {
+  const ConstraintManager &cm = query.constraints;
+  std::vector< ref<Expr> > constraints(cm.begin(), cm.end());
+  unsigned n = constraints.size();
+
+  std::list<CacheEntry*>::iterator best = cache.end();
+  unsigned bestSize = 0;
+  for (std::list<CacheEntry*>::iterator it = cache.begin(),
+         ie = cache.end(); it != ie; ++it) {
+    const std::vector< ref<Expr> > &prefix = (*it)->constraints;
+    unsigned size = prefix.size();
+    if (size > n || (best != cache.end() && size <= bestSize))
+      continue;
+    // Check the last element first, it is the most likely to differ.
+    if (size && prefix[size - 1].get() != constraints[size - 1].get())
+      continue;
+    unsigned i = 0;
+    while (i != size && prefix[i].get() == constraints[i].get())
+      ++i;
+    if (i == size) {
+      best = it;
+      bestSize = size;
+    }
+  }
+
+  if (best != cache.end() && bestSize == n) {
+    CacheEntry *entry = *best;
+    cache.erase(best);
+    cache.push_front(entry);
+    return entry;
+  }
+
+  CacheEntry *entry = new CacheEntry();
+  entry->constraints.swap(constraints);
+  if (best != cache.end())
+    entry->domain = (*best)->domain;
+
+  IntervalPropagator propagator(entry->domain);
+  for (unsigned i = bestSize; i != n; ++i)
+    propagator.constrain(entry->constraints[i], true);
+
+  cache.push_front(entry);
+  if (cache.size() > MaxCachedDomains) {
+    delete cache.back();
+    cache.pop_back();
+  }
+
+  return entry;
+}
+
+/// getWitness - Try to find an assignment satisfying all the constraints
+/// of the entry, by picking the lower or upper bound of every byte.
+bool IntervalSolver::getWitness(CacheEntry *entry) {
+  if (entry->witnessState != CacheEntry::WitnessUnknown)
+    return entry->witnessState == CacheEntry::WitnessValid;
+
+  entry->witnessState = CacheEntry::WitnessInvalid;
+  if (entry->domain.infeasible)
+    return false;
+
+  for (unsigned useUpper = 0; useUpper != 2; ++useUpper) {
+    Assignment candidate;
+    for (IntervalDomain::bytes_ty::const_iterator
+           it = entry->domain.bytes.begin(), ie = entry->domain.bytes.end();
+         it != ie; ++it) {
+      std::vector<unsigned char> &values = candidate.bindings[it->first];
+      values.reserve(it->second.size());
+      for (unsigned i = 0; i != it->second.size(); ++i)
+        values.push_back(useUpper ? it->second[i].hi : it->second[i].lo);
+    }
+
+    if (candidate.satisfies(entry->constraints.begin(),
+                            entry->constraints.end())) {
+      entry->witness = candidate;
+      entry->witnessState = CacheEntry::WitnessValid;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+IncompleteSolver::PartialValidity
+IntervalSolver::computeValidity(const Query &query) {
+  CacheEntry *entry = getEntry(query);
+  if (entry->domain.infeasible) {
+    ++stats::queryIntervalHits;
+    return IncompleteSolver::MustBeTrue;
+  }
+
+  IntervalEvaluator evaluator(entry->domain);
+  AbstractValue v = evaluator.evaluate(query.expr);
+  if (v.isFixed()) {
+    ++stats::queryIntervalHits;
+    return v.lo ? IncompleteSolver::MustBeTrue : IncompleteSolver::MustBeFalse;
+  }
+
+  if (getWitness(entry)) {
+    ++stats::queryIntervalHits;
+    return entry->witness.evaluate(query.expr)->isTrue() ?
+      IncompleteSolver::MayBeTrue : IncompleteSolver::MayBeFalse;
+  }
+
+  ++stats::queryIntervalMisses;
+  return IncompleteSolver::None;
+}
+
+IncompleteSolver::PartialValidity
+IntervalSolver::computeTruth(const Query &query) {
+  CacheEntry *entry = getEntry(query);
+  if (entry->domain.infeasible) {
+    ++stats::queryIntervalHits;
+    return IncompleteSolver::MustBeTrue;
+  }
+
+  IntervalEvaluator evaluator(entry->domain);
+  AbstractValue v = evaluator.evaluate(query.expr);
+  if (v.isFixed() && v.lo) {
+    ++stats::queryIntervalHits;
+    return IncompleteSolver::MustBeTrue;
+  }
+
+  // A false assignment is only known to exist if the constraints are
+  // satisfiable, which requires a witness.
+  if (getWitness(entry) && entry->witness.evaluate(query.expr)->isFalse()) {
+    ++stats::queryIntervalHits;
+    return IncompleteSolver::MayBeFalse;
+  }
+
+  ++stats::queryIntervalMisses;
+  return IncompleteSolver::None;
+}
+
+bool IntervalSolver::computeValue(const Query &query, ref<Expr> &result) {
+  CacheEntry *entry = getEntry(query);
+  if (entry->domain.infeasible)
+    return false;
+
+  IntervalEvaluator evaluator(entry->domain);
+  AbstractValue v = evaluator.evaluate(query.expr);
+  if (v.isFixed()) {
+    ++stats::queryIntervalHits;
+    result = ConstantExpr::create(v.lo, query.expr->getWidth());
+    return true;
+  }
+
+  if (getWitness(entry)) {
+    ref<Expr> value = entry->witness.evaluate(query.expr);
+    if (isa<ConstantExpr>(value)) {
+      ++stats::queryIntervalHits;
+      result = value;
+      return true;
+    }
+  }
+
+  ++stats::queryIntervalMisses;
+  return false;
+}
+
+bool
+IntervalSolver::computeInitialValues(const Query &query,
+                                     const std::vector<const Array*>
+                                       &objects,
+                                     std::vector< std::vector<unsigned char> >
+                                       &values,
+                                     bool &hasSolution) {
+  CacheEntry *entry = getEntry(query);
+  if (entry->domain.infeasible) {
+    ++stats::queryIntervalHits;
+    hasSolution = false;
+    return true;
+  }
+
+  if (!getWitness(entry)) {
+    ++stats::queryIntervalMisses;
+    return false;
+  }
+
+  // Initial values are requested with a false query expression, anything
+  // else has to hold under the witness as well.
+  if (!entry->witness.evaluate(query.expr)->isFalse()) {
+    ++stats::queryIntervalMisses;
+    return false;
+  }
+
+  ++stats::queryIntervalHits;
+  hasSolution = true;
+  for (unsigned i = 0; i != objects.size(); ++i) {
+    const Array *array = objects[i];
+    Assignment::bindings_ty::const_iterator it =
+      entry->witness.bindings.find(array);
+    if (it != entry->witness.bindings.end())
+      values.push_back(it->second);
+    else
+      values.push_back(std::vector<unsigned char>(array->size, 0));
+  }
+
+  return true;
+}
+
+} // End anonymous namespace
+
+Solver *klee::createIntervalSolver(Solver *s) {
+  return new Solver(new StagedSolverImpl(new IntervalSolver(), s));
+}
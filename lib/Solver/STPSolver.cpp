@@ -20,6 +20,7 @@
 #include "llvm/Support/ErrorHandling.h"
 
 #include <errno.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <signal.h>
 #include <sys/wait.h>
@@ -52,6 +53,30 @@ static const unsigned shared_memory_size = 1 << 16;
 static const unsigned shared_memory_size = 1 << 20;
 #endif
 
+/// Set while the solver forks to run a query, whose result the child
+/// writes to the shared memory region.
+static bool forkingForQuery = false;
+
+static void allocateSharedMemory() {
+  shared_memory_id =
+      shmget(IPC_PRIVATE, shared_memory_size, IPC_CREAT | 0700);
+  if (shared_memory_id < 0)
+    llvm::report_fatal_error("unable to allocate shared memory region");
+  shared_memory_ptr = (unsigned char *)shmat(shared_memory_id, NULL, 0);
+  if (shared_memory_ptr == (void *)-1)
+    llvm::report_fatal_error("unable to attach shared memory region");
+  shmctl(shared_memory_id, IPC_RMID, NULL);
+}
+
+/// A process forked for another purpose (e.g. to write a test case) may
+/// run queries at the same time as its parent, so it gets its own region.
+static void onFork() {
+  if (forkingForQuery || !shared_memory_ptr)
+    return;
+  shmdt(shared_memory_ptr);
+  allocateSharedMemory();
+}
+
 static void stp_error_handler(const char *err_msg) {
   fprintf(stderr, "error: STP Error: %s\n", err_msg);
   abort();
@@ -102,14 +127,13 @@ STPSolverImpl::STPSolverImpl(bool _useForkedSTP, bool _optimizeDivides)
 
   if (useForkedSTP) {
     assert(shared_memory_id == 0 && "shared memory id already allocated");
-    shared_memory_id =
-        shmget(IPC_PRIVATE, shared_memory_size, IPC_CREAT | 0700);
-    if (shared_memory_id < 0)
-      llvm::report_fatal_error("unable to allocate shared memory region");
-    shared_memory_ptr = (unsigned char *)shmat(shared_memory_id, NULL, 0);
-    if (shared_memory_ptr == (void *)-1)
-      llvm::report_fatal_error("unable to attach shared memory region");
-    shmctl(shared_memory_id, IPC_RMID, NULL);
+    allocateSharedMemory();
+
+    static bool registeredForkHandler = false;
+    if (!registeredForkHandler) {
+      pthread_atfork(0, 0, onFork);
+      registeredForkHandler = true;
+    }
   }
 }
 
@@ -227,7 +251,9 @@ runAndGetCexForked(::VC vc, STPBuilder *builder, ::VCExpr q,
 
   fflush(stdout);
   fflush(stderr);
+  forkingForQuery = true;
   int pid = fork();
+  forkingForQuery = false;
   if (pid == -1) {
     fprintf(stderr, "ERROR: fork failed (for STP)");
     if (!IgnoreSolverFailures)
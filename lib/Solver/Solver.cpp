@@ -10,6 +10,8 @@
 #include "klee/Solver.h"
 #include "klee/SolverImpl.h"
 #include "klee/Constraints.h"
+#include "klee/util/Assignment.h"
+#include "klee/util/ExprUtil.h"
 
 using namespace klee;
 
@@ -107,80 +109,122 @@ Solver::getInitialValues(const Query& query,
   return success;
 }
 
-std::pair< ref<Expr>, ref<Expr> > Solver::getRange(const Query& query) {
+bool Solver::getValues(const ConstraintManager &constraints,
+                       const std::vector< ref<Expr> > &exprs,
+                       std::vector< ref<ConstantExpr> > &results) {
+  std::vector< ref<Expr> > symbolic;
+  for (std::vector< ref<Expr> >::const_iterator it = exprs.begin(),
+         ie = exprs.end(); it != ie; ++it)
+    if (!isa<ConstantExpr>(*it))
+      symbolic.push_back(*it);
+
+  // Compute a single satisfying assignment for every object involved, and
+  // evaluate all the expressions under it.
+  std::vector<const Array*> objects;
+  std::vector< std::vector<unsigned char> > values;
+  findSymbolicObjects(symbolic.begin(), symbolic.end(), objects);
+  if (!objects.empty() &&
+      !getInitialValues(Query(constraints, ConstantExpr::alloc(0, Expr::Bool)),
+                        objects, values))
+    return false;
+
+  Assignment assignment(objects, values);
+  results.clear();
+  results.reserve(exprs.size());
+  for (std::vector< ref<Expr> >::const_iterator it = exprs.begin(),
+         ie = exprs.end(); it != ie; ++it) {
+    ref<Expr> value = assignment.evaluate(*it);
+    assert(isa<ConstantExpr>(value) && "assignment evaluation did not fold");
+    results.push_back(cast<ConstantExpr>(value));
+  }
+
+  return true;
+}
+
+bool Solver::getUniqueValue(const Query& query, ref<ConstantExpr> &result,
+                            bool &isUnique) {
+  if (!getValue(query, result))
+    return false;
+
+  if (isa<ConstantExpr>(query.expr)) {
+    isUnique = true;
+    return true;
+  }
+
+  return mustBeTrue(query.withExpr(EqExpr::create(query.expr, result)),
+                    isUnique);
+}
+
+bool Solver::getRange(const Query& query, ref<ConstantExpr> &minResult,
+                      ref<ConstantExpr> &maxResult,
+                      ref<ConstantExpr> &sampleResult) {
   ref<Expr> e = query.expr;
   Expr::Width width = e->getWidth();
-  uint64_t min, max;
+  uint64_t min, max, sample;
 
   if (width==1) {
     Solver::Validity result;
     if (!evaluate(query, result))
-      assert(0 && "computeValidity failed");
+      return false;
     switch (result) {
     case Solver::True: 
-      min = max = 1; break;
+      min = max = sample = 1; break;
     case Solver::False: 
-      min = max = 0; break;
+      min = max = sample = 0; break;
     default:
-      min = 0, max = 1; break;
+      min = sample = 0, max = 1; break;
     }
-  } else if (ConstantExpr *CE = dyn_cast<ConstantExpr>(e)) {
-    min = max = CE->getZExtValue();
   } else {
-    // binary search for # of useful bits
-    uint64_t lo=0, hi=width, mid, bits=0;
-    while (lo<hi) {
-      mid = lo + (hi - lo)/2;
-      bool res;
-      bool success = 
-        mustBeTrue(query.withExpr(
-                     EqExpr::create(LShrExpr::create(e,
-                                                     ConstantExpr::create(mid, 
-                                                                          width)),
-                                    ConstantExpr::create(0, width))),
-                   res);
-
-      assert(success && "FIXME: Unhandled solver failure");
-      (void) success;
-
-      if (res) {
-        hi = mid;
-      } else {
-        lo = mid+1;
-      }
+    ref<ConstantExpr> value;
+    bool isUnique;
+    if (!getUniqueValue(query, value, isUnique))
+      return false;
+
+    sample = value->getZExtValue();
+    if (isUnique) {
+      min = max = sample;
+    } else {
+      // binary search for # of useful bits, which is at least the number of
+      // bits needed to represent the sample
+      uint64_t lo=0, hi=width, mid, bits=0;
+      for (uint64_t v = sample; v; v >>= 1)
+        ++lo;
+      while (lo<hi) {
+        mid = lo + (hi - lo)/2;
+        bool res;
+        if (!mustBeTrue(query.withExpr(
+                          EqExpr::create(LShrExpr::create(e,
+                                                          ConstantExpr::create(mid, 
+                                                                               width)),
+                                         ConstantExpr::create(0, width))),
+                        res))
+          return false;
 
+        if (res) {
+          hi = mid;
+        } else {
+          lo = mid+1;
+        }
+      }
       bits = lo;
-    }
-    
-    // could binary search for training zeros and offset
-    // min max but unlikely to be very useful
-
-    // check common case
-    bool res = false;
-    bool success = 
-      mayBeTrue(query.withExpr(EqExpr::create(e, ConstantExpr::create(0, 
-                                                                      width))), 
-                res);
-
-    assert(success && "FIXME: Unhandled solver failure");      
-    (void) success;
 
-    if (res) {
-      min = 0;
-    } else {
-      // binary search for min
-      lo=0, hi=bits64::maxValueOfNBits(bits);
+      // binary search for min, below the sample
+      lo=0, hi=sample;
+      bool res = false;
+      if (sample && !mayBeTrue(query.withExpr(EqExpr::create(e, 
+                                                              ConstantExpr::create(0, 
+                                                                                   width))), 
+                               res))
+        return false;
+      if (res)
+        hi = 0;
       while (lo<hi) {
         mid = lo + (hi - lo)/2;
-        bool res = false;
-        bool success = 
-          mayBeTrue(query.withExpr(UleExpr::create(e, 
-                                                   ConstantExpr::create(mid, 
-                                                                        width))),
-                    res);
-
-        assert(success && "FIXME: Unhandled solver failure");      
-        (void) success;
+        if (!mayBeTrue(query.withExpr(UleExpr::create(e, 
+                                                      ConstantExpr::create(mid, 
+                                                                           width))),
+                       res))
+          return false;
 
         if (res) {
           hi = mid;
@@ -188,36 +232,40 @@ std::pair< ref<Expr>, ref<Expr> > Solver::getRange(const Query& query) {
           lo = mid+1;
         }
       }
-
       min = lo;
-    }
 
-    // binary search for max
-    lo=min, hi=bits64::maxValueOfNBits(bits);
-    while (lo<hi) {
-      mid = lo + (hi - lo)/2;
-      bool res;
-      bool success = 
-        mustBeTrue(query.withExpr(UleExpr::create(e, 
-                                                  ConstantExpr::create(mid, 
-                                                                       width))),
-                   res);
-
-      assert(success && "FIXME: Unhandled solver failure");      
-      (void) success;
-
-      if (res) {
-        hi = mid;
-      } else {
-        lo = mid+1;
+      // binary search for max, above the sample
+      lo=sample, hi=bits64::maxValueOfNBits(bits);
+      while (lo<hi) {
+        mid = lo + (hi - lo)/2;
+        if (!mustBeTrue(query.withExpr(UleExpr::create(e, 
+                                                       ConstantExpr::create(mid, 
+                                                                            width))),
+                        res))
+          return false;
+
+        if (res) {
+          hi = mid;
+        } else {
+          lo = mid+1;
+        }
       }
+      max = lo;
     }
-
-    max = lo;
   }
 
-  return std::make_pair(ConstantExpr::create(min, width),
-                        ConstantExpr::create(max, width));
+  minResult = ConstantExpr::create(min, width);
+  maxResult = ConstantExpr::create(max, width);
+  sampleResult = ConstantExpr::create(sample, width);
+  return true;
+}
+
+std::pair< ref<Expr>, ref<Expr> > Solver::getRange(const Query& query) {
+  ref<ConstantExpr> min, max, sample;
+  bool success = getRange(query, min, max, sample);
+  assert(success && "FIXME: Unhandled solver failure");
+  (void) success;
+  return std::make_pair(min, max);
 }
 
 void Query::dump() const {
@@ -19,9 +19,12 @@ Statistic stats::queryCacheHits("QueryCacheHits", "QChits") ;
 Statistic stats::queryCacheMisses("QueryCacheMisses", "QCmisses");
 Statistic stats::queryCexCacheHits("QueryCexCacheHits", "QCexHits") ;
 Statistic stats::queryCexCacheMisses("QueryCexCacheMisses", "QCexMisses");
+Statistic stats::queryCoalesced("QueryCoalesced", "QCoal");
 Statistic stats::queryConstructTime("QueryConstructTime", "QBtime") ;
 Statistic stats::queryConstructs("QueriesConstructs", "QB");
 Statistic stats::queryCounterexamples("QueriesCEX", "Qcex");
+Statistic stats::queryIntervalHits("QueryIntervalHits", "QIntHits");
+Statistic stats::queryIntervalMisses("QueryIntervalMisses", "QIntMisses");
 Statistic stats::queryTime("QueryTime", "Qtime");
 
 #ifdef DEBUG
@@ -0,0 +1,123 @@
+//===-- Affinity.cpp ------------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Internal/System/Affinity.h"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace klee;
+
+#ifdef __linux__
+
+/// Parse a list of cores in the sysfs format (e.g. "0-3,8-11").
+static void parseCPUList(const std::string &list, std::vector<unsigned> &cpus) {
+  std::istringstream is(list);
+  std::string range;
+  while (std::getline(is, range, ',')) {
+    unsigned first, last;
+    char dash;
+    std::istringstream rs(range);
+    if (!(rs >> first))
+      continue;
+    if (!(rs >> dash >> last))
+      last = first;
+    for (unsigned cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+      cpus.push_back(cpu);
+  }
+}
+
+/// Return the cores of each NUMA node, or of a single node if the
+/// topology is unknown.
+static void getNodes(std::vector<std::vector<unsigned> > &nodes) {
+  for (unsigned node = 0;; ++node) {
+    std::ostringstream path;
+    path << "/sys/devices/system/node/node" << node << "/cpulist";
+    std::ifstream f(path.str().c_str());
+    std::string list;
+    if (!std::getline(f, list))
+      break;
+    nodes.push_back(std::vector<unsigned>());
+    parseCPUList(list, nodes.back());
+  }
+
+  if (nodes.empty()) {
+    nodes.push_back(std::vector<unsigned>());
+    for (unsigned cpu = 0; cpu != CPU_SETSIZE; ++cpu)
+      nodes.back().push_back(cpu);
+  }
+}
+
+bool util::pinToCore(unsigned slot) {
+  cpu_set_t allowed;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) < 0)
+    return false;
+
+  // Order the allowed cores by interleaving the nodes.
+  std::vector<std::vector<unsigned> > nodes;
+  getNodes(nodes);
+  std::vector<unsigned> cores;
+  for (unsigned i = 0, done = 0; done != nodes.size(); ++i) {
+    done = 0;
+    for (unsigned n = 0; n != nodes.size(); ++n) {
+      if (i >= nodes[n].size()) {
+        ++done;
+        continue;
+      }
+      if (CPU_ISSET(nodes[n][i], &allowed))
+        cores.push_back(nodes[n][i]);
+    }
+  }
+  if (cores.empty())
+    return false;
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cores[slot % cores.size()], &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+bool util::pinToCurrentNode() {
+  int cpu = sched_getcpu();
+  if (cpu < 0)
+    return false;
+
+  std::vector<std::vector<unsigned> > nodes;
+  getNodes(nodes);
+  for (unsigned n = 0; n != nodes.size(); ++n) {
+    std::vector<unsigned> &cpus = nodes[n];
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    bool found = false;
+    for (unsigned i = 0; i != cpus.size(); ++i) {
+      CPU_SET(cpus[i], &set);
+      found |= cpus[i] == (unsigned) cpu;
+    }
+    if (found)
+      return sched_setaffinity(0, sizeof(set), &set) == 0;
+  }
+  return false;
+}
+
+#else
+
+bool util::pinToCore(unsigned slot) {
+  return false;
+}
+
+bool util::pinToCurrentNode() {
+  return false;
+}
+
+#endif
@@ -0,0 +1,76 @@
+//===-- SharedBitmap.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Internal/Support/SharedBitmap.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace klee;
+
+/// The file starts with a header identifying the bitmap (magic, number of
+/// bits and the two halves of the tag), followed by the words of the bitmap.
+static const uint32_t kMagic = 0x4b434f56; // "KCOV"
+static const unsigned kHeaderWords = 4;
+
+SharedBitmap::SharedBitmap() : words(0), numBits(0), mappedSize(0) {
+}
+
+SharedBitmap::~SharedBitmap() {
+  if (words)
+    munmap((void*) (words - kHeaderWords), mappedSize);
+}
+
+bool SharedBitmap::open(const std::string &path, unsigned _numBits,
+                        uint64_t tag) {
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0664);
+  if (fd < 0)
+    return false;
+
+  // The first process to take the lock initializes the file.
+  size_t size = (kHeaderWords + (_numBits + 31) / 32) * sizeof(uint32_t);
+  struct stat st;
+  if (flock(fd, LOCK_EX) < 0 || fstat(fd, &st) < 0 ||
+      (st.st_size == 0 && ftruncate(fd, size) < 0) ||
+      (st.st_size != 0 && (size_t) st.st_size != size)) {
+    close(fd);
+    return false;
+  }
+
+  void *p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+  volatile uint32_t *header = (volatile uint32_t*) p;
+  if (st.st_size == 0) {
+    header[0] = kMagic;
+    header[1] = _numBits;
+    header[2] = (uint32_t) tag;
+    header[3] = (uint32_t) (tag >> 32);
+  }
+  bool valid = header[0] == kMagic && header[1] == _numBits &&
+    header[2] == (uint32_t) tag && header[3] == (uint32_t) (tag >> 32);
+  // The mapping stays valid once the file is closed.
+  close(fd);
+  if (!valid) {
+    munmap(p, size);
+    return false;
+  }
+
+  if (words)
+    munmap((void*) (words - kHeaderWords), mappedSize);
+  words = header + kHeaderWords;
+  numBits = _numBits;
+  mappedSize = size;
+  return true;
+}
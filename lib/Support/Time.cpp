@@ -13,6 +13,8 @@
 #include "llvm/Support/TimeValue.h"
 #include "llvm/Support/Process.h"
 
+#include <sys/resource.h>
+
 using namespace llvm;
 using namespace klee;
 
@@ -22,6 +24,13 @@ double util::getUserTime() {
   return (user.seconds() + (double) user.nanoseconds() * 1e-9);
 }
 
+double util::getChildrenUserTime() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_CHILDREN, &usage) < 0)
+    return 0;
+  return usage.ru_utime.tv_sec + (double) usage.ru_utime.tv_usec * 1e-6;
+}
+
 double util::getWallTime() {
   sys::TimeValue now = getWallTimeVal();
   return (now.seconds() + ((double) now.nanoseconds() * 1e-9));
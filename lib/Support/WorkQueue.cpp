@@ -0,0 +1,167 @@
+//===-- WorkQueue.cpp -----------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Internal/Support/WorkQueue.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace klee;
+
+/// Return the names of the entries of a directory, in order, skipping the
+/// hidden ones (used for files which are still being written).
+static void listDirectory(const std::string &directory,
+                          std::vector<std::string> &result) {
+  DIR *dir = opendir(directory.c_str());
+  if (!dir)
+    return;
+  while (struct dirent *entry = readdir(dir))
+    if (entry->d_name[0] != '.')
+      result.push_back(entry->d_name);
+  closedir(dir);
+  std::sort(result.begin(), result.end());
+}
+
+WorkQueue::WorkQueue(const std::string &directory, unsigned _workerID)
+  : pendingDir(directory + "/pending"),
+    countFile(directory + "/jobs"),
+    abortFile(directory + "/aborted"),
+    workerID(_workerID),
+    jobsPushed(0) {
+  std::ostringstream claimed;
+  claimed << directory << "/claimed" << workerID << ".path";
+  claimedFile = claimed.str();
+}
+
+WorkQueue::~WorkQueue() {
+}
+
+bool WorkQueue::create(const std::string &directory) {
+  std::string dirs[] = { directory, directory + "/pending" };
+  for (unsigned i = 0; i != 2; ++i)
+    if (mkdir(dirs[i].c_str(), 0775) < 0 && errno != EEXIST)
+      return false;
+  return true;
+}
+
+bool WorkQueue::updateCount(int delta, unsigned *result) const {
+  int fd = open(countFile.c_str(), O_RDWR | O_CREAT, 0664);
+  if (fd < 0)
+    return false;
+  if (flock(fd, delta ? LOCK_EX : LOCK_SH) < 0) {
+    close(fd);
+    return false;
+  }
+
+  char buf[32];
+  ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+  bool success = n >= 0;
+  buf[n > 0 ? n : 0] = 0;
+  unsigned count = strtoul(buf, 0, 10) + delta;
+  if (success && delta) {
+    int len = snprintf(buf, sizeof(buf), "%u\n", count);
+    success = ftruncate(fd, 0) == 0 && pwrite(fd, buf, len, 0) == len;
+  }
+  // Closing the file releases the lock.
+  close(fd);
+  if (success && result)
+    *result = count;
+  return success;
+}
+
+bool WorkQueue::push(const std::vector<bool> &path) {
+  // Name jobs by the length of their prefix, so the shallowest (and
+  // usually largest) subtrees are claimed first.
+  std::ostringstream name;
+  name << path.size() + 1000000000u << "-" << workerID << "-"
+       << jobsPushed++ << ".path";
+  std::string tmp = pendingDir + "/." + name.str();
+  {
+    std::ofstream f(tmp.c_str(), std::ios::out | std::ios::binary);
+    if (!f.good())
+      return false;
+    for (std::vector<bool>::const_iterator it = path.begin(),
+           ie = path.end(); it != ie; ++it)
+      f << (*it ? "1\n" : "0\n");
+    if (!f.good()) {
+      unlink(tmp.c_str());
+      return false;
+    }
+  }
+
+  // Count the job before it can be claimed, then publish it atomically.
+  if (!updateCount(1, 0)) {
+    unlink(tmp.c_str());
+    return false;
+  }
+  if (rename(tmp.c_str(), (pendingDir + "/" + name.str()).c_str()) < 0) {
+    updateCount(-1, 0);
+    unlink(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool WorkQueue::pop(std::vector<bool> &path) {
+  std::vector<std::string> jobs;
+  listDirectory(pendingDir, jobs);
+  for (std::vector<std::string>::iterator it = jobs.begin(),
+         ie = jobs.end(); it != ie; ++it) {
+    // Only one of the workers renaming the same job succeeds.
+    if (rename((pendingDir + "/" + *it).c_str(), claimedFile.c_str()) < 0)
+      continue;
+
+    std::ifstream f(claimedFile.c_str(), std::ios::in | std::ios::binary);
+    unsigned value;
+    path.clear();
+    while (f >> value)
+      path.push_back(!!value);
+    f.close();
+    unlink(claimedFile.c_str());
+    return true;
+  }
+  return false;
+}
+
+void WorkQueue::done() {
+  updateCount(-1, 0);
+}
+
+unsigned WorkQueue::getNumPending() const {
+  std::vector<std::string> jobs;
+  listDirectory(pendingDir, jobs);
+  return jobs.size();
+}
+
+void WorkQueue::abort() {
+  int fd = open(abortFile.c_str(), O_WRONLY | O_CREAT, 0664);
+  if (fd >= 0)
+    close(fd);
+}
+
+bool WorkQueue::isAborted() const {
+  return access(abortFile.c_str(), F_OK) == 0;
+}
+
+bool WorkQueue::isFinished() const {
+  if (isAborted())
+    return true;
+  unsigned count;
+  return updateCount(0, &count) && count == 0;
+}
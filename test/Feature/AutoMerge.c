@@ -0,0 +1,27 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --auto-merge %t.bc 2>&1 | FileCheck %s
+// RUN: rm -rf %t.klee-out-2
+// RUN: %klee --output-dir=%t.klee-out-2 --auto-merge --search=random-path %t.bc 2>&1 | FileCheck %s
+
+// Without merging, each of the four branches doubles the number of paths.
+// CHECK: KLEE: done: generated tests = 1
+
+int main() {
+  int a, b, c, d, r = 0;
+  klee_make_symbolic(&a, sizeof(a), "a");
+  klee_make_symbolic(&b, sizeof(b), "b");
+  klee_make_symbolic(&c, sizeof(c), "c");
+  klee_make_symbolic(&d, sizeof(d), "d");
+
+  if (a > 0)
+    r++;
+  if (b > 0)
+    r++;
+  if (c > 0)
+    r++;
+  if (d > 0)
+    r++;
+
+  return r;
+}
@@ -0,0 +1,32 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out %t.klee-out2
+// RUN: %klee --output-dir=%t.klee-out --checkpoint-interval=1000 --stop-after-n-tests=1 --dump-states-on-halt=false %t.bc
+// RUN: test -f %t.klee-out/checkpoint
+// RUN: %klee --output-dir=%t.klee-out2 --resume=%t.klee-out %t.bc 2>&1 | FileCheck %s
+
+// The paths left when halting are explored after resuming, and only them,
+// including the targets of the symbolic switch.
+// CHECK: KLEE: done: generated tests = 11
+
+int main() {
+  int x, y, z, r = 0;
+  klee_make_symbolic(&x, sizeof x, "x");
+  klee_make_symbolic(&y, sizeof y, "y");
+  klee_make_symbolic(&z, sizeof z, "z");
+
+  if (x > 0)
+    r += 1;
+  switch (y) {
+  case 1:
+    r += 2;
+    break;
+  case 2:
+    r += 4;
+    break;
+  default:
+    break;
+  }
+  if (z > 0)
+    r += 8;
+  return r;
+}
@@ -0,0 +1,21 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --concolic %t.bc 2>&1 | FileCheck %s
+
+// The first run (on zeros) takes the false side of the first branch. Its
+// negation gives an input taking the true side, whose run in turn gives an
+// input for the other side of the second branch.
+// CHECK: KLEE: concolic: 3 runs, 0 inputs left
+// CHECK: KLEE: done: generated tests = 3
+
+int main() {
+  int x;
+  klee_make_symbolic(&x, sizeof x, "x");
+
+  if (x > 10) {
+    if (x < 20)
+      return 1;
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,25 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --dist-workers=2 --dist-share-interval=0 %t.bc 2>&1 | FileCheck %s
+// RUN: test -f %t.klee-out/worker0/info
+// RUN: test -f %t.klee-out/worker1/info
+
+// However the paths are split among the workers, each is explored once.
+// CHECK: KLEE: done: distributed: workers = 2
+// CHECK: KLEE: done: distributed: duplicate tests = 0
+// CHECK: KLEE: done: distributed: generated tests = 8
+
+int main() {
+  int x, y, z, r = 0;
+  klee_make_symbolic(&x, sizeof x, "x");
+  klee_make_symbolic(&y, sizeof y, "y");
+  klee_make_symbolic(&z, sizeof z, "z");
+
+  if (x > 0)
+    r += 1;
+  if (y > 0)
+    r += 2;
+  if (z > 0)
+    r += 4;
+  return r;
+}
@@ -0,0 +1,22 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t.bc
+// RUN: rm -rf %t.seeds %t.dup %t.klee-out
+// RUN: %klee --output-dir=%t.seeds %t.bc
+// RUN: mkdir %t.dup
+// RUN: cp %t.seeds/test000001.ktest %t.dup/a.ktest
+// RUN: cp %t.seeds/test000001.ktest %t.dup/b.ktest
+// RUN: %klee --output-dir=%t.klee-out --seed-workers=2 --seed-out-dir=%t.dup --only-replay-seeds %t.bc 2>&1 | FileCheck %s
+
+// Each worker replays the same seed, so their tests have the same input
+// even though the workers ran with different arguments.
+// CHECK: KLEE: done: distributed: workers = 2
+// CHECK: KLEE: done: distributed: duplicate tests = 1
+// CHECK: KLEE: done: distributed: generated tests = 1
+
+int main() {
+  int x;
+  klee_make_symbolic(&x, sizeof x, "x");
+
+  if (x > 0)
+    return 1;
+  return 0;
+}
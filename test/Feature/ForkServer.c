@@ -0,0 +1,25 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out %t.job1 %t.job2
+// RUN: echo "%t.job1 --search=dfs" > %t.jobs
+// RUN: echo "%t.job2 --search=bfs -- abc" >> %t.jobs
+// RUN: %klee --output-dir=%t.klee-out --fork-server=%t.jobs %t.bc 2>&1 | FileCheck %s
+// RUN: test -f %t.job1/test000002.ktest
+// RUN: test -f %t.job2/test000002.ktest
+// RUN: not test -f %t.klee-out/test000001.ktest
+// RUN: rm -rf %t.klee-out2 %t.job3
+// RUN: echo "%t.job3 --search=bfs" > %t.jobs2
+// RUN: %klee --output-dir=%t.klee-out2 --search=dfs --fork-server=%t.jobs2 %t.bc 2>&1 | FileCheck --check-prefix=CHECK-REPEATED %s
+
+// CHECK: KLEE: fork server: 2 jobs, 0 failed
+
+// A job cannot add to the searchers given to the server.
+// CHECK-REPEATED: --search was already given to the fork server
+// CHECK-REPEATED: KLEE: fork server: 1 jobs, 1 failed
+
+int main(int argc, char **argv) {
+  int x;
+  klee_make_symbolic(&x, sizeof x, "x");
+  if (x > 0)
+    return 1;
+  return 0;
+}
@@ -0,0 +1,30 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --loop-iteration-budget=2 --output-loop-forks %t.bc 2>&1 | FileCheck %s
+// RUN: FileCheck --check-prefix=CHECK-FORKS --input-file=%t.klee-out/loop-forks.txt %s
+
+// The states past two iterations are held back until nothing else is left.
+// The iterations of the concrete loop, which is over, do not count.
+// CHECK: KLEE: increasing loop iteration budget to: 4
+// CHECK: KLEE: increasing loop iteration budget to: 8
+// CHECK-NOT: KLEE: increasing loop iteration budget to: 16
+// CHECK: KLEE: done: generated tests = 256
+
+// Every fork happens in the symbolic loop, whose header is its condition.
+// CHECK-FORKS: # forks
+// CHECK-FORKS-NEXT: 255 main {{.*}}LoopBudget.c:26
+
+int main() {
+  unsigned char n;
+  unsigned bits[16];
+  unsigned i, r = 0;
+  klee_make_symbolic(&n, sizeof n, "n");
+
+  for (i = 0; i < 16; ++i)
+    bits[i] = 1 << i;
+
+  for (i = 0; i < 8; ++i)
+    if (n & bits[i])
+      ++r;
+  return r;
+}
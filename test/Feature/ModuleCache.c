@@ -0,0 +1,18 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out %t.klee-out2 %t.cache
+// RUN: %klee --output-dir=%t.klee-out --module-cache=%t.cache %t.bc 2>&1 | FileCheck --check-prefix=CHECK-FIRST %s
+// RUN: %klee --output-dir=%t.klee-out2 --module-cache=%t.cache %t.bc 2>&1 | FileCheck --check-prefix=CHECK-SECOND %s
+// RUN: diff %t.klee-out/assembly.ll %t.klee-out2/assembly.ll
+// RUN: test -f %t.klee-out2/test000002.ktest
+
+// CHECK-FIRST-NOT: using the prepared module
+// CHECK-SECOND: KLEE: using the prepared module
+// CHECK-SECOND: KLEE: done: generated tests = 2
+
+int main() {
+  int x;
+  klee_make_symbolic(&x, sizeof x, "x");
+  if (x > 10)
+    return 1;
+  return 0;
+}
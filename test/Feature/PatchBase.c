@@ -0,0 +1,26 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -DBASE -c -o %t.base.bc
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --patch-base=%t.base.bc %t.bc 2>&1 | FileCheck %s
+// RUN: test -f %t.klee-out/test000002.ktest
+// RUN: rm -rf %t.klee-out-2
+// RUN: %klee --output-dir=%t.klee-out-2 --patch-base=%t.base.bc --seed-out-dir=%t.klee-out %t.bc 2>&1 | FileCheck %s
+
+// CHECK: NOTE: 1 basic blocks changed since
+
+int check(int x) {
+  if (x > 10) {
+#ifdef BASE
+    return 1;
+#else
+    return 2;
+#endif
+  }
+  return 0;
+}
+
+int main() {
+  int x;
+  klee_make_symbolic(&x, sizeof x, "x");
+  return check(x);
+}
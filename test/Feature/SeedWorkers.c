@@ -0,0 +1,27 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t.bc
+// RUN: rm -rf %t.seeds %t.klee-out
+// RUN: %klee --output-dir=%t.seeds %t.bc
+// RUN: %klee --output-dir=%t.klee-out --seed-workers=2 --seed-out-dir=%t.seeds --only-replay-seeds %t.bc 2>&1 | FileCheck %s
+// RUN: test -f %t.klee-out/worker0/seeding.txt
+// RUN: test -f %t.klee-out/worker1/seeding.txt
+// RUN: test -f %t.klee-out/coverage.txt
+
+// Each worker replays two of the four seeds.
+// CHECK: KLEE: done: distributed: workers = 2
+// CHECK: KLEE: done: distributed: duplicate tests = 0
+// CHECK: KLEE: done: distributed: generated tests = 4
+
+int main() {
+  int x, y;
+  klee_make_symbolic(&x, sizeof x, "x");
+  klee_make_symbolic(&y, sizeof y, "y");
+
+  if (x > 0) {
+    if (y > 0)
+      return 3;
+    return 2;
+  }
+  if (y > 0)
+    return 1;
+  return 0;
+}
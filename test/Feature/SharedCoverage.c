@@ -0,0 +1,27 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t.bc
+// RUN: %llvmgcc %s -DLIMIT=20 -emit-llvm -g -O0 -c -o %t.other.bc
+// RUN: rm -rf %t.klee-out %t.klee-out2 %t.klee-out3 %t.cov
+// RUN: %klee --output-dir=%t.klee-out --shared-coverage=%t.cov --only-output-states-covering-new %t.bc 2>&1 | FileCheck --check-prefix=CHECK-FIRST %s
+// RUN: %klee --output-dir=%t.klee-out2 --shared-coverage=%t.cov --only-output-states-covering-new %t.bc 2>&1 | FileCheck --check-prefix=CHECK-SECOND %s
+// RUN: not %klee --output-dir=%t.klee-out3 --shared-coverage=%t.cov %t.other.bc 2>&1 | FileCheck --check-prefix=CHECK-OTHER %s
+
+// The second run covers nothing the first one did not.
+// CHECK-FIRST-NOT: generated tests = 0
+// CHECK-SECOND: KLEE: done: generated tests = 0
+
+// A program with as many instructions but different ones cannot share it.
+// CHECK-OTHER: unable to map shared coverage file
+
+#ifndef LIMIT
+#define LIMIT 10
+#endif
+
+int main() {
+  int x;
+  klee_make_symbolic(&x, sizeof x, "x");
+  if (x > LIMIT)
+    return 1;
+  if (x < 0)
+    return 2;
+  return 0;
+}
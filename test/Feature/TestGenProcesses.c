@@ -0,0 +1,24 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --test-gen-processes=2 --write-pcs %t.bc 2>&1 | FileCheck %s
+// RUN: test -f %t.klee-out/test000004.ktest
+// RUN: test -f %t.klee-out/test000004.pc
+// RUN: not test -f %t.klee-out/test000005.ktest
+// RUN: ls %t.klee-out | grep assert.err | count 1
+
+// CHECK: KLEE: done: generated tests = 4
+
+#include <assert.h>
+
+int main() {
+  int x, y;
+  klee_make_symbolic(&x, sizeof x, "x");
+  klee_make_symbolic(&y, sizeof y, "y");
+
+  if (x > 0) {
+    if (y > 0)
+      assert(x + y != 2);
+    return 1;
+  }
+  return y > 0;
+}
@@ -19,8 +19,10 @@
 #include "klee/Internal/ADT/TreeStream.h"
 #include "klee/Internal/Support/Debug.h"
 #include "klee/Internal/Support/ModuleUtil.h"
+#include "klee/Internal/System/Affinity.h"
 #include "klee/Internal/System/Time.h"
 #include "klee/Internal/Support/PrintVersion.h"
+#include "klee/Internal/Support/WorkQueue.h"
 #include "klee/Internal/Support/ErrorHandling.h"
 
 #if LLVM_VERSION_CODE > LLVM_VERSION(3, 2)
@@ -65,11 +67,15 @@
 #include <sys/stat.h>
 #include <sys/wait.h>
 
+#include <algorithm>
 #include <cctype>
 #include <cerrno>
+#include <deque>
 #include <fstream>
 #include <iomanip>
+#include <iostream>
 #include <iterator>
+#include <set>
 #include <sstream>
 
 
@@ -205,6 +211,11 @@ namespace {
   cl::list<std::string>
   SeedOutDir("seed-out-dir");
 
+  cl::opt<std::string>
+  PatchBase("patch-base",
+            cl::desc("Previous version of the program. The basic blocks which changed since are targeted by --search=targeted, which becomes the default search (use --seed-out-dir to seed with the tests of the previous run)"),
+            cl::value_desc("bitcode file"));
+
   cl::list<std::string>
   LinkLibraries("link-llvm-lib",
 		cl::desc("Link the given libraries before execution"),
@@ -226,6 +237,61 @@ namespace {
   Watchdog("watchdog",
            cl::desc("Use a watchdog process to enforce --max-time."),
            cl::init(0));
+
+  cl::opt<unsigned>
+  TestGenProcesses("test-gen-processes",
+                   cl::desc("Solve for and write test cases in up to this many forked processes, while exploration goes on (default=0 (off))"),
+                   cl::init(0));
+
+  cl::opt<unsigned>
+  DistWorkers("dist-workers",
+              cl::desc("Explore with this many local worker processes sharing a work queue, then merge their coverage and tests. If a worker fails, the others are stopped (default=0 (off))"),
+              cl::init(0));
+
+  cl::opt<std::string>
+  DistDir("dist-dir",
+          cl::desc("Run as a worker taking path prefixes to explore from the given work queue directory (set by --dist-workers)"),
+          cl::value_desc("directory"));
+
+  cl::opt<unsigned>
+  DistWorkerID("dist-worker-id",
+               cl::desc("Identifier of this worker in the work queue (set by --dist-workers)"),
+               cl::init(0));
+
+  cl::opt<unsigned>
+  SeedWorkers("seed-workers",
+              cl::desc("Replay the seeds in this many local worker processes, each taking a share of them and stopping after seeding, then merge their coverage and tests (default=0 (off))"),
+              cl::init(0));
+
+  cl::opt<unsigned>
+  SeedShare("seed-share",
+            cl::desc("Only replay the seeds whose index modulo --seed-shares is this (set by --seed-workers)"),
+            cl::init(0));
+
+  cl::opt<unsigned>
+  SeedShares("seed-shares",
+             cl::desc("Number of shares the seeds are split into (set by --seed-workers)"),
+             cl::init(0));
+
+  cl::opt<std::string>
+  ForkServer("fork-server",
+             cl::desc("Prepare the program once, then run each job read from the given file (- for stdin) in a forked process. A job is a line \"<output-dir> [options...] [-- program arguments...]\", whose options cannot repeat those of the server"),
+             cl::value_desc("file"));
+
+  cl::opt<std::string>
+  Resume("resume",
+         cl::desc("Explore the states left in the checkpoint of the given output directory (see --checkpoint-interval). The saved paths are executed again, without solver queries at two-way branches, but still at switches"),
+         cl::value_desc("directory"));
+
+  cl::opt<bool>
+  PinCores("pin-cores",
+           cl::desc("Pin each KLEE process to a core, spreading the workers of --dist-workers and --seed-workers over the NUMA nodes, and run its test case processes on the same node (default=off)"),
+           cl::init(false));
+
+  cl::opt<unsigned>
+  PinCoreSlot("pin-core-slot",
+              cl::desc("With --pin-cores, the slot of the core to pin to, or of the first worker's core; give each KLEE run on the machine its own range of slots (default=0)"),
+              cl::init(0));
 }
 
 extern cl::opt<double> MaxTime;
@@ -247,6 +313,16 @@ private:
   int m_argc;
   char **m_argv;
 
+  // processes writing test cases, oldest first
+  std::deque<int> m_testGenPids;
+
+  void writeTestCase(const ExecutionState &state,
+                     const char *errorMessage,
+                     const char *errorSuffix,
+                     unsigned id,
+                     const std::vector<unsigned char> &concreteBranches,
+                     const std::vector<unsigned char> &symbolicBranches);
+
   const std::pair<bool, std::string>
     programArgumentsToString(bool success,
 			     const std::vector< std::pair<std::string,
@@ -267,6 +343,9 @@ public:
                        const char *errorMessage,
                        const char *errorSuffix);
 
+  // wait until at most the given number of test cases are being written
+  void waitForTestCases(unsigned maxPending = 0);
+
   std::string getOutputFilename(const std::string &filename);
   llvm::raw_fd_ostream *openOutputFile(const std::string &filename);
   std::string getTestFilename(const std::string &suffix, unsigned id);
@@ -377,6 +456,7 @@ KleeHandler::KleeHandler(int argc, char **argv)
 }
 
 KleeHandler::~KleeHandler() {
+  waitForTestCases();
   if (m_pathWriter) delete m_pathWriter;
   if (m_symPathWriter) delete m_symPathWriter;
   fclose(klee_warning_file);
@@ -438,7 +518,8 @@ const std::pair<bool, std::string>
 void KleeHandler::setInterpreter(Interpreter *i) {
   m_interpreter = i;
 
-  if (WritePaths) {
+  // The work queue is fed from the paths of the states handed over.
+  if (WritePaths || !DistDir.empty()) {
     m_pathWriter = new TreeStreamWriter(getOutputFilename("paths.ts"));
     assert(m_pathWriter->good());
     m_interpreter->setPathWriter(m_pathWriter);
@@ -502,60 +583,114 @@ void KleeHandler::processTestCase(const ExecutionState &state,
   }
 
   if (!NoOutput) {
-    std::vector< std::pair<std::string, std::vector<unsigned char> > > out;
-    bool success = m_interpreter->getSymbolicSolution(state, out);
-
-    if (!success)
-      klee_warning("unable to get symbolic solution, losing test case");
+    // The test ID is assigned here, so the output does not depend on the
+    // order in which test cases are written.
+    unsigned id = ++m_testIndex;
 
-    double start_time = util::getWallTime();
+    // The path streams are shared with the exploration, so they are read
+    // before forking.
+    std::vector<unsigned char> concreteBranches, symbolicBranches;
+    if (m_pathWriter)
+      m_pathWriter->readStream(m_interpreter->getPathStreamID(state),
+                               concreteBranches);
+    if (m_symPathWriter)
+      m_symPathWriter->readStream(m_interpreter->getSymbolicPathStreamID(state),
+                                  symbolicBranches);
 
-    unsigned id = ++m_testIndex;
+    // Firehose issues go to a single file, so they are written in order.
+    int pid = -1;
+    if (TestGenProcesses && !(FirehoseOutput && errorMessage)) {
+      waitForTestCases(TestGenProcesses - 1);
+
+      // Nothing buffered before the fork may be written twice.
+      m_infoFile->flush();
+      fflush(NULL);
+      pid = fork();
+      if (pid < 0)
+        klee_warning_once(0, "unable to fork test case process: %s",
+                          strerror(errno));
+    }
 
-    if (success) {
-      KTest b;
-      b.numArgs = m_argc;
-      b.args = m_argv;
-      b.symArgvs = 0;
-      b.symArgvLen = 0;
-      b.numObjects = out.size();
-      b.objects = new KTestObject[b.numObjects];
-      assert(b.objects);
-      for (unsigned i=0; i<b.numObjects; i++) {
-        KTestObject *o = &b.objects[i];
-        o->name = const_cast<char*>(out[i].first.c_str());
-        o->numBytes = out[i].second.size();
-        o->bytes = new unsigned char[o->numBytes];
-        assert(o->bytes);
-        std::copy(out[i].second.begin(), out[i].second.end(), o->bytes);
+    if (pid > 0) {
+      m_testGenPids.push_back(pid);
+    } else {
+      // Leave the core to the exploration, but stay close to the memory
+      // shared with it.
+      if (pid == 0 && PinCores)
+        util::pinToCurrentNode();
+      writeTestCase(state, errorMessage, errorSuffix, id, concreteBranches,
+                    symbolicBranches);
+      if (pid == 0) {
+        fflush(NULL);
+        _exit(0);
       }
+    }
 
-      if (!kTest_toFile(&b, getOutputFilename(getTestFilename("ktest", id)).c_str())) {
-        klee_warning("unable to write output test case, losing it");
-      }
+    if (m_testIndex == StopAfterNTests)
+      m_interpreter->setHaltExecution(true);
+  }
+}
 
-      for (unsigned i=0; i<b.numObjects; i++)
-        delete[] b.objects[i].bytes;
-      delete[] b.objects;
+void KleeHandler::writeTestCase(const ExecutionState &state,
+                                const char *errorMessage,
+                                const char *errorSuffix,
+                                unsigned id,
+                                const std::vector<unsigned char>
+                                  &concreteBranches,
+                                const std::vector<unsigned char>
+                                  &symbolicBranches) {
+  std::vector< std::pair<std::string, std::vector<unsigned char> > > out;
+  bool success = m_interpreter->getSymbolicSolution(state, out);
+
+  if (!success)
+    klee_warning("unable to get symbolic solution, losing test case");
+
+  double start_time = util::getWallTime();
+
+  if (success) {
+    KTest b;
+    b.numArgs = m_argc;
+    b.args = m_argv;
+    b.symArgvs = 0;
+    b.symArgvLen = 0;
+    b.numObjects = out.size();
+    b.objects = new KTestObject[b.numObjects];
+    assert(b.objects);
+    for (unsigned i=0; i<b.numObjects; i++) {
+      KTestObject *o = &b.objects[i];
+      o->name = const_cast<char*>(out[i].first.c_str());
+      o->numBytes = out[i].second.size();
+      o->bytes = new unsigned char[o->numBytes];
+      assert(o->bytes);
+      std::copy(out[i].second.begin(), out[i].second.end(), o->bytes);
     }
 
-    if (errorMessage) {
-      llvm::raw_ostream *f = openTestFile(errorSuffix, id);
-      *f << errorMessage;
-      delete f;
+    if (!kTest_toFile(&b, getOutputFilename(getTestFilename("ktest", id)).c_str())) {
+      klee_warning("unable to write output test case, losing it");
     }
 
-    if (FirehoseOutput && errorMessage) {
-      char errorType[256];
-      std::istringstream iss(errorMessage);
-      iss.getline(errorType, 256);
+    for (unsigned i=0; i<b.numObjects; i++)
+      delete[] b.objects[i].bytes;
+    delete[] b.objects;
+  }
+
+  if (errorMessage) {
+    llvm::raw_ostream *f = openTestFile(errorSuffix, id);
+    *f << errorMessage;
+    delete f;
+  }
 
-      std::ostringstream msgSs;
-      msgSs << errorType;
-      std::pair<bool, std::string> posixProgArgs;
-      posixProgArgs = programArgumentsToString(success, out);
+  if (FirehoseOutput && errorMessage) {
+    char errorType[256];
+    std::istringstream iss(errorMessage);
+    iss.getline(errorType, 256);
 
-      if (success) {
+    std::ostringstream msgSs;
+    msgSs << errorType;
+    std::pair<bool, std::string> posixProgArgs;
+    posixProgArgs = programArgumentsToString(success, out);
+
+    if (success) {
 	if (posixProgArgs.first) {
 	  msgSs << ".\n The error occurs when " << m_argv[0]
 		<< " is executed with ";
@@ -570,91 +705,92 @@ void KleeHandler::processTestCase(const ExecutionState &state,
 		<< "that leads to the error by using the klee-replay "
 		<< "tool on the corresponding .ktest file from the output "
 		<< "directory.";
-      }
-
-      firehose::Message msg(msgSs.str());
-      firehose::Trace trace(state.dumpStackInFirehose());
-      firehose::Location loc((*(trace.getStates().rbegin())).getLocation());
-      firehose::Issue issue(msg, loc, trace);
-      fprintf(klee_firehose_file, "%s\n", issue.toXML().c_str());
-      fflush(klee_firehose_file);
-    }
-    
-    if (m_pathWriter) {
-      std::vector<unsigned char> concreteBranches;
-      m_pathWriter->readStream(m_interpreter->getPathStreamID(state),
-                               concreteBranches);
-      llvm::raw_fd_ostream *f = openTestFile("path", id);
-      for (std::vector<unsigned char>::iterator I = concreteBranches.begin(),
-                                                E = concreteBranches.end();
-           I != E; ++I) {
-        *f << *I << "\n";
-      }
-      delete f;
     }
 
-    if (errorMessage || WritePCs) {
-      std::string constraints;
-      m_interpreter->getConstraintLog(state, constraints,Interpreter::KQUERY);
-      llvm::raw_ostream *f = openTestFile("pc", id);
-      *f << constraints;
-      delete f;
+    firehose::Message msg(msgSs.str());
+    firehose::Trace trace(state.dumpStackInFirehose());
+    firehose::Location loc((*(trace.getStates().rbegin())).getLocation());
+    firehose::Issue issue(msg, loc, trace);
+    fprintf(klee_firehose_file, "%s\n", issue.toXML().c_str());
+    fflush(klee_firehose_file);
+  }
+  
+  if (m_pathWriter) {
+    llvm::raw_fd_ostream *f = openTestFile("path", id);
+    for (std::vector<unsigned char>::const_iterator
+           I = concreteBranches.begin(), E = concreteBranches.end();
+         I != E; ++I) {
+      *f << *I << "\n";
     }
+    delete f;
+  }
 
-    if (WriteCVCs) {
-      // FIXME: If using Z3 as the core solver the emitted file is actually
-      // SMT-LIBv2 not CVC which is a bit confusing
-      std::string constraints;
-      m_interpreter->getConstraintLog(state, constraints, Interpreter::STP);
-      llvm::raw_ostream *f = openTestFile("cvc", id);
-      *f << constraints;
-      delete f;
-    }
+  if (errorMessage || WritePCs) {
+    std::string constraints;
+    m_interpreter->getConstraintLog(state, constraints,Interpreter::KQUERY);
+    llvm::raw_ostream *f = openTestFile("pc", id);
+    *f << constraints;
+    delete f;
+  }
 
-    if(WriteSMT2s) {
-      std::string constraints;
-        m_interpreter->getConstraintLog(state, constraints, Interpreter::SMTLIB2);
-        llvm::raw_ostream *f = openTestFile("smt2", id);
-        *f << constraints;
-        delete f;
-    }
+  if (WriteCVCs) {
+    // FIXME: If using Z3 as the core solver the emitted file is actually
+    // SMT-LIBv2 not CVC which is a bit confusing
+    std::string constraints;
+    m_interpreter->getConstraintLog(state, constraints, Interpreter::STP);
+    llvm::raw_ostream *f = openTestFile("cvc", id);
+    *f << constraints;
+    delete f;
+  }
 
-    if (m_symPathWriter) {
-      std::vector<unsigned char> symbolicBranches;
-      m_symPathWriter->readStream(m_interpreter->getSymbolicPathStreamID(state),
-                                  symbolicBranches);
-      llvm::raw_fd_ostream *f = openTestFile("sym.path", id);
-      for (std::vector<unsigned char>::iterator I = symbolicBranches.begin(), E = symbolicBranches.end(); I!=E; ++I) {
-        *f << *I << "\n";
-      }
+  if(WriteSMT2s) {
+    std::string constraints;
+      m_interpreter->getConstraintLog(state, constraints, Interpreter::SMTLIB2);
+      llvm::raw_ostream *f = openTestFile("smt2", id);
+      *f << constraints;
       delete f;
+  }
+
+  if (m_symPathWriter) {
+    llvm::raw_fd_ostream *f = openTestFile("sym.path", id);
+    for (std::vector<unsigned char>::const_iterator I = symbolicBranches.begin(), E = symbolicBranches.end(); I!=E; ++I) {
+      *f << *I << "\n";
     }
+    delete f;
+  }
 
-    if (WriteCov) {
-      std::map<const std::string*, std::set<unsigned> > cov;
-      m_interpreter->getCoveredLines(state, cov);
-      llvm::raw_ostream *f = openTestFile("cov", id);
-      for (std::map<const std::string*, std::set<unsigned> >::iterator
-             it = cov.begin(), ie = cov.end();
-           it != ie; ++it) {
-        for (std::set<unsigned>::iterator
-               it2 = it->second.begin(), ie = it->second.end();
-             it2 != ie; ++it2)
-          *f << *it->first << ":" << *it2 << "\n";
-      }
-      delete f;
+  if (WriteCov) {
+    std::map<const std::string*, std::set<unsigned> > cov;
+    m_interpreter->getCoveredLines(state, cov);
+    llvm::raw_ostream *f = openTestFile("cov", id);
+    for (std::map<const std::string*, std::set<unsigned> >::iterator
+           it = cov.begin(), ie = cov.end();
+         it != ie; ++it) {
+      for (std::set<unsigned>::iterator
+             it2 = it->second.begin(), ie = it->second.end();
+           it2 != ie; ++it2)
+        *f << *it->first << ":" << *it2 << "\n";
     }
+    delete f;
+  }
 
-    if (m_testIndex == StopAfterNTests)
-      m_interpreter->setHaltExecution(true);
+  if (WriteTestInfo) {
+    double elapsed_time = util::getWallTime() - start_time;
+    llvm::raw_ostream *f = openTestFile("info", id);
+    *f << "Time to generate test case: "
+       << elapsed_time << "s\n";
+    delete f;
+  }
+}
 
-    if (WriteTestInfo) {
-      double elapsed_time = util::getWallTime() - start_time;
-      llvm::raw_ostream *f = openTestFile("info", id);
-      *f << "Time to generate test case: "
-         << elapsed_time << "s\n";
-      delete f;
-    }
+void KleeHandler::waitForTestCases(unsigned maxPending) {
+  while (m_testGenPids.size() > maxPending) {
+    int status, res = waitpid(m_testGenPids.front(), &status, 0);
+    if (res < 0 && errno == EINTR)
+      continue;
+    if (res < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+      klee_warning("test case process failed, test case may be incomplete");
+    m_testGenPids.pop_front();
   }
 }
 
@@ -1267,6 +1403,358 @@ static llvm::Module *linkWithUclibc(llvm::Module *mainModule, StringRef libDir)
 }
 #endif
 
+/// Load and materialize a bitcode module, exiting on error. What describes
+/// the module in error messages.
+static Module *loadModule(const std::string &file, const char *what) {
+  std::string ErrorMsg;
+  Module *module = 0;
+#if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
+  OwningPtr<MemoryBuffer> BufferPtr;
+  error_code ec=MemoryBuffer::getFileOrSTDIN(file.c_str(), BufferPtr);
+  if (ec) {
+    klee_error("error loading %s '%s': %s", what, file.c_str(),
+               ec.message().c_str());
+  }
+
+  module = getLazyBitcodeModule(BufferPtr.get(), getGlobalContext(), &ErrorMsg);
+
+  if (module) {
+    // The module has taken ownership of the MemoryBuffer so release it
+    // from the OwningPtr
+    BufferPtr.take();
+    if (module->MaterializeAllPermanently(&ErrorMsg)) {
+      delete module;
+      module = 0;
+    }
+  }
+  if (!module)
+    klee_error("error loading %s '%s': %s", what, file.c_str(),
+               ErrorMsg.c_str());
+#else
+  auto Buffer = MemoryBuffer::getFileOrSTDIN(file.c_str());
+  if (!Buffer)
+    klee_error("error loading %s '%s': %s", what, file.c_str(),
+               Buffer.getError().message().c_str());
+
+  auto moduleOrError = getLazyBitcodeModule(Buffer->get(), getGlobalContext());
+
+  if (!moduleOrError) {
+    klee_error("error loading %s '%s': %s", what, file.c_str(),
+               moduleOrError.getError().message().c_str());
+  }
+  else {
+    // The module has taken ownership of the MemoryBuffer so release it
+    // from the std::unique_ptr
+    Buffer->release();
+  }
+
+  module = *moduleOrError;
+  if (auto ec = module->materializeAllPermanently()) {
+    klee_error("error loading %s '%s': %s", what, file.c_str(),
+               ec.message().c_str());
+  }
+#endif
+  return module;
+}
+
+/// Return true if the command line argument sets the given option, and
+/// whether its value is given in the next argument.
+static bool isOption(const std::string &arg, const std::string &name,
+                     bool &separateValue) {
+  std::string::size_type start = arg.find_first_not_of('-');
+  if (start == 0 || start > 2 || arg.compare(start, name.size(), name))
+    return false;
+  std::string::size_type end = start + name.size();
+  separateValue = end == arg.size();
+  return separateValue || arg[end] == '=';
+}
+
+static void copyFile(const std::string &from, const std::string &to) {
+  std::ifstream in(from.c_str(), std::ios::in | std::ios::binary);
+  std::ofstream out(to.c_str(), std::ios::out | std::ios::binary);
+  if (!in.good() || !out.good())
+    klee_error("unable to copy \"%s\" to \"%s\"", from.c_str(), to.c_str());
+  out << in.rdbuf();
+}
+
+/// Return a key identifying the input of a test, made of its objects only:
+/// the rest of the .ktest file (the arguments of the worker) differs
+/// between workers. Unreadable tests get a key of their own.
+static std::string getTestInputKey(const std::string &path) {
+  KTest *kTest = kTest_fromFile(path.c_str());
+  if (!kTest)
+    return "\0" + path;
+
+  std::ostringstream key;
+  for (unsigned i = 0; i != kTest->numObjects; ++i) {
+    KTestObject &o = kTest->objects[i];
+    key << o.name << '\0' << o.numBytes << '\0';
+    key.write((const char*) o.bytes, o.numBytes);
+  }
+  kTest_free(kTest);
+  return key.str();
+}
+
+/// Run KLEE in --dist-workers or --seed-workers worker processes, with
+/// the same arguments but each in its own output directory. The workers
+/// either share a work queue in the output directory, or each replay a
+/// share of the seeds. Once they are done, merge the lines they covered
+/// and the tests they generated, dropping duplicate tests.
+static int runCoordinator(int argc, char **argv) {
+  KleeHandler handler(argc, argv);
+  unsigned numWorkers = DistWorkers ? DistWorkers : SeedWorkers;
+  std::string queueDir = handler.getOutputFilename("queue");
+  if (DistWorkers) {
+    if (!WorkQueue::create(queueDir))
+      klee_error("cannot create work queue \"%s\": %s", queueDir.c_str(),
+                 strerror(errno));
+
+    // The first job explores the whole tree.
+    WorkQueue(queueDir, DistWorkers).push(std::vector<bool>());
+  }
+
+  std::vector<std::string> workerDirs;
+  std::vector<int> pids;
+  for (unsigned i = 0; i != numWorkers; ++i) {
+    std::ostringstream dir;
+    dir << "worker" << i;
+    workerDirs.push_back(handler.getOutputFilename(dir.str()));
+
+    // The options must come before the input file, as the arguments after
+    // it go to the program.
+    std::vector<std::string> args;
+    args.push_back(argv[0]);
+    args.push_back("-output-dir=" + workerDirs.back());
+    args.push_back("-output-coverage");
+    std::ostringstream id;
+    if (DistWorkers) {
+      args.push_back("-dist-dir=" + queueDir);
+      id << "-dist-worker-id=" << i;
+      args.push_back(id.str());
+    } else {
+      // Searching after seeding would explore the same states in every
+      // worker.
+      args.push_back("-only-seed");
+      id << "-seed-share=" << i;
+      args.push_back(id.str());
+      id.str("");
+      id << "-seed-shares=" << numWorkers;
+      args.push_back(id.str());
+    }
+    for (int j = 1; j < argc; ++j) {
+      std::string arg = argv[j];
+      bool separateValue;
+      if (arg == InputFile) {
+        args.insert(args.end(), argv + j, argv + argc);
+        break;
+      }
+      if (isOption(arg, "output-dir", separateValue) ||
+          isOption(arg, "dist-workers", separateValue) ||
+          isOption(arg, "seed-workers", separateValue)) {
+        if (separateValue)
+          ++j;
+        continue;
+      }
+      args.push_back(arg);
+    }
+
+    int pid = fork();
+    if (pid < 0)
+      klee_error("unable to fork worker: %s", strerror(errno));
+    if (!pid) {
+      std::vector<char*> cargs;
+      for (unsigned j = 0; j != args.size(); ++j)
+        cargs.push_back(const_cast<char*>(args[j].c_str()));
+      cargs.push_back(0);
+      execvp(cargs[0], &cargs[0]);
+      perror("execvp");
+      _exit(1);
+    }
+    pids.push_back(pid);
+  }
+
+  int result = 0;
+  bool aborted = false;
+  unsigned numRunning = numWorkers;
+  double nextReport = util::getWallTime() + 10;
+  while (numRunning) {
+    for (unsigned i = 0; i != pids.size(); ++i) {
+      int status;
+      if (!pids[i] || waitpid(pids[i], &status, WNOHANG) <= 0)
+        continue;
+      pids[i] = 0;
+      --numRunning;
+      if (WIFEXITED(status) && !WEXITSTATUS(status))
+        continue;
+      klee_warning("worker %u failed", i);
+      result = 1;
+
+      // The job of the failed worker is never done, so the others would
+      // wait for it forever: end the exploration, halting them as on ctrl-c.
+      if (DistWorkers && !aborted) {
+        klee_warning("stopping the other workers");
+        WorkQueue(queueDir, DistWorkers).abort();
+        for (unsigned j = 0; j != pids.size(); ++j)
+          if (pids[j])
+            kill(pids[j], SIGINT);
+        aborted = true;
+      }
+    }
+    if (!numRunning)
+      break;
+
+    // Gather the seeding progress of the workers.
+    if (SeedWorkers && util::getWallTime() >= nextReport) {
+      nextReport = util::getWallTime() + 10;
+      for (unsigned i = 0; i != workerDirs.size(); ++i) {
+        std::ifstream f((workerDirs[i] + "/seeding.txt").c_str());
+        std::string line;
+        if (pids[i] && std::getline(f, line))
+          klee_message("seeding: worker %u: %s", i, line.c_str());
+      }
+    }
+    usleep(100000);
+  }
+
+  // Merge the tests, in worker order, keeping the files of each test
+  // (.ktest, .err, .path, ...) together.
+  std::set<std::string> tests, covered;
+  unsigned numTests = 0, numDuplicates = 0;
+  for (unsigned i = 0; i != workerDirs.size(); ++i) {
+    std::vector<std::string> kTestFiles, files;
+    KleeHandler::getKTestFilesInDir(workerDirs[i], kTestFiles);
+    std::sort(kTestFiles.begin(), kTestFiles.end());
+    if (DIR *dir = opendir(workerDirs[i].c_str())) {
+      while (struct dirent *entry = readdir(dir))
+        files.push_back(entry->d_name);
+      closedir(dir);
+    }
+
+    for (std::vector<std::string>::iterator it = kTestFiles.begin(),
+           ie = kTestFiles.end(); it != ie; ++it) {
+      if (!tests.insert(getTestInputKey(*it)).second) {
+        ++numDuplicates;
+        continue;
+      }
+
+      ++numTests;
+      std::string stem = sys::path::stem(*it).str() + ".";
+      for (std::vector<std::string>::iterator fit = files.begin(),
+             fie = files.end(); fit != fie; ++fit)
+        if (!fit->compare(0, stem.size(), stem))
+          copyFile(workerDirs[i] + "/" + *fit,
+                   handler.getOutputFilename(
+                     handler.getTestFilename(fit->substr(stem.size()),
+                                             numTests)));
+    }
+
+    std::ifstream f((workerDirs[i] + "/coverage.txt").c_str());
+    std::string line;
+    while (std::getline(f, line))
+      covered.insert(line);
+  }
+
+  llvm::raw_ostream *os = handler.openOutputFile("coverage.txt");
+  for (std::set<std::string>::iterator it = covered.begin(),
+         ie = covered.end(); it != ie; ++it)
+    *os << *it << "\n";
+  delete os;
+
+  std::stringstream stats;
+  stats << "\n";
+  stats << "KLEE: done: distributed: workers = " << numWorkers << "\n";
+  stats << "KLEE: done: distributed: covered lines = "
+        << covered.size() << "\n";
+  stats << "KLEE: done: distributed: duplicate tests = "
+        << numDuplicates << "\n";
+  stats << "KLEE: done: distributed: generated tests = "
+        << numTests << "\n";
+  handler.getInfoStream() << stats.str();
+  llvm::errs() << stats.str();
+
+  return result;
+}
+
+/// Read the jobs of the fork server and run each in a forked process,
+/// one at a time. Return false in the server once all jobs are done, and
+/// true in the process of a job, once its options and program arguments
+/// are set.
+static bool runForkServer(int argc, char **argv, std::string &line) {
+  std::ifstream file;
+  if (ForkServer != "-") {
+    file.open(ForkServer.c_str());
+    if (!file.good())
+      klee_error("unable to open --fork-server file: %s", ForkServer.c_str());
+  }
+  std::istream &jobs = ForkServer == "-" ? std::cin : file;
+
+  unsigned numJobs = 0, numFailed = 0;
+  while (!interrupted && std::getline(jobs, line)) {
+    std::istringstream words(line);
+    std::string outputDir;
+    if (!(words >> outputDir) || outputDir[0] == '#')
+      continue;
+
+    ++numJobs;
+    fflush(NULL);
+    int pid = fork();
+    if (pid < 0)
+      klee_error("unable to fork job: %s", strerror(errno));
+
+    if (pid == 0) {
+      // Options which were already given to the server cannot be given
+      // again (the values of list options would be appended to those of
+      // the server), and those used to prepare the program have no effect.
+      std::vector<std::string> options;
+      std::vector<const char*> jobArgv(1, argv[0]);
+      std::string word;
+      bool programArgs = false;
+      InputArgv.clear();
+      while (words >> word) {
+        if (programArgs)
+          InputArgv.push_back(word);
+        else if (word == "--")
+          programArgs = true;
+        else
+          options.push_back(word);
+      }
+      for (unsigned i = 0; i != options.size(); ++i) {
+        const std::string &option = options[i];
+        std::string::size_type start = option.find_first_not_of('-');
+        if (start && start != std::string::npos) {
+          std::string name = option.substr(start, option.find('=') - start);
+          for (int j = 1; j < argc && argv[j] != InputFile; ++j) {
+            bool separateValue;
+            if (isOption(argv[j], name, separateValue))
+              klee_error("--%s was already given to the fork server",
+                         name.c_str());
+          }
+        }
+        jobArgv.push_back(option.c_str());
+      }
+      cl::ParseCommandLineOptions(jobArgv.size(),
+                                  const_cast<char**>(&jobArgv[0]),
+                                  " klee\n");
+      OutputDir = outputDir;
+      return true;
+    }
+
+    int status = 0, res;
+    do {
+      res = waitpid(pid, &status, 0);
+    } while (res < 0 && errno == EINTR);
+    if (res < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+      ++numFailed;
+      klee_warning("job %u (%s) failed", numJobs, outputDir.c_str());
+    } else {
+      klee_message("job %u (%s) done", numJobs, outputDir.c_str());
+    }
+  }
+
+  klee_message("fork server: %u jobs, %u failed", numJobs, numFailed);
+  return false;
+}
+
 int main(int argc, char **argv, char **envp) {
   atexit(llvm_shutdown);  // Call llvm_shutdown() on exit.
 
@@ -1275,6 +1763,28 @@ int main(int argc, char **argv, char **envp) {
   parseArguments(argc, argv);
   sys::PrintStackTraceOnErrorSignal();
 
+  if (!Resume.empty() &&
+      (DistWorkers || SeedWorkers || !DistDir.empty() ||
+       ReplayPathFile != "" || !ReplayKTestDir.empty() ||
+       !ReplayKTestFile.empty() || !SeedOutFile.empty() ||
+       !SeedOutDir.empty()))
+    klee_error("--resume cannot be used with distributed exploration, "
+               "replay or seeds");
+
+  if (DistWorkers || SeedWorkers) {
+    if (DistWorkers && SeedWorkers)
+      klee_error("--dist-workers cannot be used with --seed-workers");
+    if (!DistDir.empty() || ReplayPathFile != "" || SeedShares)
+      klee_error("--dist-workers and --seed-workers cannot be used with "
+                 "--dist-dir, --seed-shares or --replay-path");
+    if (SeedWorkers && SeedOutFile.empty() && SeedOutDir.empty())
+      klee_error("--seed-workers used without --seed-out or --seed-out-dir");
+    return runCoordinator(argc, argv);
+  }
+
+  if (!ForkServer.empty() && (Watchdog || !DistDir.empty()))
+    klee_error("--fork-server cannot be used with --watchdog or --dist-dir");
+
   if (Watchdog) {
     if (MaxTime==0) {
       klee_error("--watchdog used without --max-time");
@@ -1340,54 +1850,26 @@ int main(int argc, char **argv, char **envp) {
 
   sys::SetInterruptFunction(interrupt_handle);
 
-  // Load the bytecode...
-  std::string ErrorMsg;
-  Module *mainModule = 0;
-#if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
-  OwningPtr<MemoryBuffer> BufferPtr;
-  error_code ec=MemoryBuffer::getFileOrSTDIN(InputFile.c_str(), BufferPtr);
-  if (ec) {
-    klee_error("error loading program '%s': %s", InputFile.c_str(),
-               ec.message().c_str());
+  // The forked solvers and the jobs of a fork server run in turn with this
+  // process, so they stay on its core.
+  if (PinCores) {
+    unsigned slot = PinCoreSlot;
+    slot += !DistDir.empty() ? DistWorkerID : SeedShare;
+    if (!util::pinToCore(slot))
+      klee_warning("unable to pin to a core");
   }
 
-  mainModule = getLazyBitcodeModule(BufferPtr.get(), getGlobalContext(), &ErrorMsg);
-
-  if (mainModule) {
-    if (mainModule->MaterializeAllPermanently(&ErrorMsg)) {
-      delete mainModule;
-      mainModule = 0;
-    }
-  }
-  if (!mainModule)
-    klee_error("error loading program '%s': %s", InputFile.c_str(),
-               ErrorMsg.c_str());
-#else
-  auto Buffer = MemoryBuffer::getFileOrSTDIN(InputFile.c_str());
-  if (!Buffer)
-    klee_error("error loading program '%s': %s", InputFile.c_str(),
-               Buffer.getError().message().c_str());
-
-  auto mainModuleOrError = getLazyBitcodeModule(Buffer->get(), getGlobalContext());
-
-  if (!mainModuleOrError) {
-    klee_error("error loading program '%s': %s", InputFile.c_str(),
-               mainModuleOrError.getError().message().c_str());
-  }
-  else {
-    // The module has taken ownership of the MemoryBuffer so release it
-    // from the std::unique_ptr
-    Buffer->release();
+  // Load the bytecode...
+  Module *mainModule = loadModule(InputFile, "program");
+
+  if (!PatchBase.empty()) {
+    Module *baseModule = loadModule(PatchBase, "patch base");
+    unsigned numChanged = markChangedCode(baseModule, mainModule);
+    klee_message("NOTE: %u basic blocks changed since %s", numChanged,
+                 PatchBase.c_str());
+    delete baseModule;
   }
 
-  mainModule = *mainModuleOrError;
-  if (auto ec = mainModule->materializeAllPermanently()) {
-    klee_error("error loading program '%s': %s", InputFile.c_str(),
-               ec.message().c_str());
-  }
-#endif
-
-
   if (WithPOSIXRuntime) {
     int r = initEnv(mainModule);
     if (r != 0)
@@ -1506,11 +1988,53 @@ int main(int argc, char **argv, char **envp) {
   const Module *finalModule =
     interpreter->setModule(mainModule, Opts);
   externalsAndGlobalsCheck(finalModule);
+  mainFn = finalModule->getFunction(EntryPoint);
+
+  if (!ForkServer.empty()) {
+    std::string job;
+    if (!runForkServer(argc, argv, job)) {
+      delete interpreter;
+      delete handler;
+      return 0;
+    }
+
+    // This is the process of a job: switch to its program arguments and
+    // output directory. The server's handler is not deleted, as it would
+    // close the warnings and messages files of the new one.
+    for (unsigned i=0; i<(unsigned) pArgc; i++)
+      delete[] pArgv[i];
+    delete[] pArgv;
+    pArgc = InputArgv.size() + 1;
+    pArgv = new char *[pArgc];
+    for (unsigned i=0; i<InputArgv.size()+1; i++) {
+      std::string &arg = (i==0 ? InputFile : InputArgv[i-1]);
+      pArgv[i] = new char[arg.size() + 1];
+      std::copy(arg.begin(), arg.end(), pArgv[i]);
+      pArgv[i][arg.size()] = 0;
+    }
+
+    handler = new KleeHandler(pArgc, pArgv);
+    interpreter->setInterpreterHandler(handler);
+    handler->setInterpreter(interpreter);
+    for (int i=0; i<argc; i++) {
+      handler->getInfoStream() << argv[i] << (i+1<argc ? " ":"\n");
+    }
+    handler->getInfoStream() << "Job: " << job << "\n";
+    handler->getInfoStream() << "PID: " << getpid() << "\n";
+  }
 
   if (ReplayPathFile != "") {
     interpreter->setReplayPath(&replayPath);
   }
 
+  unsigned numResumedPaths = 0;
+  if (!Resume.empty()) {
+    if (!interpreter->loadCheckpoint(Resume, numResumedPaths))
+      klee_error("unable to load checkpoint from: %s", Resume.c_str());
+    klee_message("resuming %u paths from: %s", numResumedPaths,
+                 Resume.c_str());
+  }
+
   char buf[256];
   time_t t[2];
   t[0] = time(NULL);
@@ -1564,11 +2088,42 @@ int main(int argc, char **argv, char **envp) {
       kTest_free(kTests.back());
       kTests.pop_back();
     }
+  } else if (!DistDir.empty()) {
+    if (RunInDir != "") {
+      int res = chdir(RunInDir.c_str());
+      if (res < 0) {
+        klee_error("Unable to change directory to: %s", RunInDir.c_str());
+      }
+    }
+
+    // Explore the subtree below each path prefix taken from the queue,
+    // until no worker has any work left, or the queue is aborted after
+    // another worker failed.
+    WorkQueue queue(DistDir, DistWorkerID);
+    interpreter->setWorkQueue(&queue);
+    while (!interrupted && !queue.isAborted()) {
+      std::vector<bool> prefix;
+      if (!queue.pop(prefix)) {
+        if (queue.isFinished())
+          break;
+        usleep(100000);
+        continue;
+      }
+      interpreter->setReplayPath(&prefix);
+      interpreter->runFunctionAsMain(mainFn, pArgc, pArgv, pEnvp);
+      interpreter->setReplayPath(0);
+      queue.done();
+    }
+    interpreter->setWorkQueue(0);
   } else {
+    // With --seed-shares, only every SeedShares-th seed is replayed here.
+    unsigned seedIndex = 0;
     std::vector<KTest *> seeds;
     for (std::vector<std::string>::iterator
            it = SeedOutFile.begin(), ie = SeedOutFile.end();
          it != ie; ++it) {
+      if (SeedShares && seedIndex++ % SeedShares != SeedShare)
+        continue;
       KTest *out = kTest_fromFile(it->c_str());
       if (!out) {
         llvm::errs() << "KLEE: unable to open: " << *it << "\n";
@@ -1581,9 +2136,13 @@ int main(int argc, char **argv, char **envp) {
          it != ie; ++it) {
       std::vector<std::string> kTestFiles;
       KleeHandler::getKTestFilesInDir(*it, kTestFiles);
+      if (SeedShares)
+        std::sort(kTestFiles.begin(), kTestFiles.end());
       for (std::vector<std::string>::iterator
              it2 = kTestFiles.begin(), ie = kTestFiles.end();
            it2 != ie; ++it2) {
+        if (SeedShares && seedIndex++ % SeedShares != SeedShare)
+          continue;
         KTest *out = kTest_fromFile(it2->c_str());
         if (!out) {
           llvm::errs() << "KLEE: unable to open: " << *it2 << "\n";
@@ -1607,7 +2166,12 @@ int main(int argc, char **argv, char **envp) {
         klee_error("Unable to change directory to: %s", RunInDir.c_str());
       }
     }
-    interpreter->runFunctionAsMain(mainFn, pArgc, pArgv, pEnvp);
+    if (SeedShares && seeds.empty())
+      klee_message("no seeds in share %u of %u", SeedShare, SeedShares);
+    else if (!Resume.empty() && !numResumedPaths)
+      klee_message("no states left to explore in checkpoint");
+    else
+      interpreter->runFunctionAsMain(mainFn, pArgc, pArgv, pEnvp);
 
     while (!seeds.empty()) {
       kTest_free(seeds.back());
@@ -1615,6 +2179,8 @@ int main(int argc, char **argv, char **envp) {
     }
   }
 
+  handler->waitForTestCases();
+
   t[1] = time(NULL);
   strftime(buf, sizeof(buf), "Finished: %Y-%m-%d %H:%M:%S\n", localtime(&t[1]));
   handler->getInfoStream() << buf;
@@ -1682,12 +2248,6 @@ int main(int argc, char **argv, char **envp) {
 
   handler->getInfoStream() << stats.str();
 
-#if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
-  // FIXME: This really doesn't look right
-  // This is preventing the module from being
-  // deleted automatically
-  BufferPtr.take();
-#endif
   delete handler;
 
   return 0;